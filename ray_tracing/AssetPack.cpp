@@ -0,0 +1,141 @@
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifndef ASSET_SOURCE_DIR
+#define ASSET_SOURCE_DIR "."
+#endif
+
+static const char PACK_MAGIC[4] = {'P', 'A', 'K', '1'};
+static const uint32_t PACK_VERSION = 1;
+static const uint64_t PACK_ALIGNMENT = 16;
+
+static AssetPack g_assetPack;
+
+bool AssetPack::Open(const std::string &path)
+{
+    entries = nullptr;
+    entryCount = 0;
+    if (!file.Open(path)) {
+        return false;
+    }
+    AssetPackHeader header;
+    if (file.Size() < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, file.Data(), sizeof(header));
+    if (memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 || header.version != PACK_VERSION ||
+        sizeof(header) + (uint64_t)header.entryCount * sizeof(AssetPackEntry) > file.Size()) {
+        return false;
+    }
+    const AssetPackEntry *index = (const AssetPackEntry*)(file.Data() + sizeof(header));
+    for (uint32_t i = 0; i < header.entryCount; ++i) {
+        if (index[i].offset > file.Size() || index[i].size > file.Size() - index[i].offset) {
+            return false;
+        }
+    }
+    entries = index;
+    entryCount = header.entryCount;
+    return true;
+}
+
+bool AssetPack::Find(const std::string &name, const unsigned char *&data, size_t &size) const
+{
+    const AssetPackEntry *end = entries + entryCount;
+    const AssetPackEntry *entry = std::lower_bound(entries, end, name, [](const AssetPackEntry &e, const std::string &key) {
+        return strncmp(e.name, key.c_str(), sizeof(e.name)) < 0;
+    });
+    if (entry == end || strncmp(entry->name, name.c_str(), sizeof(entry->name)) != 0) {
+        return false;
+    }
+    data = file.Data() + entry->offset;
+    size = (size_t)entry->size;
+    return true;
+}
+
+bool WriteAssetPack(const std::string &path, const std::string &rootDir, std::vector<std::string> names)
+{
+    std::sort(names.begin(), names.end());
+    std::vector<AssetPackEntry> index(names.size());
+    std::vector<std::vector<char> > contents(names.size());
+    uint64_t offset = sizeof(AssetPackHeader) + names.size() * sizeof(AssetPackEntry);
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (names[i].size() >= sizeof(index[i].name)) {
+            return false;
+        }
+        std::ifstream in(rootDir + "/" + names[i], std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+        contents[i].assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        memset(index[i].name, 0, sizeof(index[i].name));
+        memcpy(index[i].name, names[i].c_str(), names[i].size());
+        offset = (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+        index[i].offset = offset;
+        index[i].size = contents[i].size();
+        offset += contents[i].size();
+    }
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        return false;
+    }
+    AssetPackHeader header;
+    memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.version = PACK_VERSION;
+    header.entryCount = (uint32_t)names.size();
+    header.reserved = 0;
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)index.data(), index.size() * sizeof(AssetPackEntry));
+    const char padding[PACK_ALIGNMENT] = {0};
+    for (size_t i = 0; i < names.size(); ++i) {
+        out.write(padding, index[i].offset - (uint64_t)out.tellp());
+        out.write(contents[i].data(), contents[i].size());
+    }
+    return out.good();
+}
+
+std::string ExecutableDir()
+{
+    char path[4096];
+#ifdef _WIN32
+    DWORD length = GetModuleFileNameA(NULL, path, sizeof(path));
+#else
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+#endif
+    if (length <= 0 || (size_t)length >= sizeof(path)) {
+        return ".";
+    }
+    std::string exe(path, length);
+    size_t slash = exe.find_last_of("/\\");
+    return slash == std::string::npos ? "." : exe.substr(0, slash);
+}
+
+bool OpenAssets()
+{
+    return g_assetPack.Open(ExecutableDir() + "/assets.pak");
+}
+
+bool LoadAsset(const std::string &name, Asset &asset)
+{
+    asset.loose.Close();
+    if (g_assetPack.IsOpen() && g_assetPack.Find(name, asset.data, asset.size)) {
+        return true;
+    }
+    if (!asset.loose.Open(std::string(ASSET_SOURCE_DIR) + "/" + name)) {
+        asset.data = nullptr;
+        asset.size = 0;
+        return false;
+    }
+    asset.data = asset.loose.Data();
+    asset.size = asset.loose.Size();
+    return true;
+}
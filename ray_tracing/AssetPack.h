@@ -0,0 +1,63 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+//single-file archive of shaders and textures:
+//header, index sorted by name, then the file contents 16-byte aligned.
+//The runtime maps the whole pack once and hands out pointers into the mapping.
+
+struct AssetPackHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+struct AssetPackEntry
+{
+    char name[48];
+    uint64_t offset;
+    uint64_t size;
+};
+
+class AssetPack
+{
+public:
+    bool Open(const std::string &path);
+
+    bool IsOpen() const { return entries != nullptr; }
+
+    bool Find(const std::string &name, const unsigned char *&data, size_t &size) const;
+
+private:
+    MappedFile file;
+    const AssetPackEntry *entries = nullptr;
+    uint32_t entryCount = 0;
+};
+
+//files are named relative to the project root, e.g. "shaders/vertex.glsl"
+bool WriteAssetPack(const std::string &path, const std::string &rootDir, std::vector<std::string> names);
+
+//view of one asset: points into the pack, or into a loose file mapped
+//from the source tree when the pack has no such entry
+struct Asset
+{
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+    MappedFile loose;
+};
+
+std::string ExecutableDir();
+
+//opens assets.pak next to the executable
+bool OpenAssets();
+
+bool LoadAsset(const std::string &name, Asset &asset);
+
+#endif
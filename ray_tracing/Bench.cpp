@@ -0,0 +1,78 @@
+#include "Bench.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+bool WriteBenchReport(const std::string &path, const FrameProfiler &profiler, int width, int height, int frames,
+                      const std::string &extra)
+{
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file) {
+        std::cout << "Failed to write " << path << std::endl;
+        return false;
+    }
+    fprintf(file, "{\"width\": %d, \"height\": %d, \"frames\": %d, \"timings\": [\n", width, height, frames);
+    bool first = true;
+    for (int pass = 0; pass < profiler.PassCount(); ++pass) {
+        for (int gpu = 0; gpu < 2; ++gpu) {
+            TimingStats stats;
+            if (!profiler.Stats(pass, gpu != 0, stats)) {
+                continue;
+            }
+            fprintf(file, "%s{\"pass\": \"%s\", \"kind\": \"%s\", \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f}",
+                    first ? "" : ",\n", profiler.PassName(pass).c_str(), gpu ? "gpu" : "cpu", stats.mean, stats.p50, stats.p95, stats.p99);
+            first = false;
+        }
+    }
+    fprintf(file, "\n]%s%s}\n", extra.empty() ? "" : ",\n", extra.c_str());
+    bool written = ferror(file) == 0;
+    fclose(file);
+    if (written) {
+        std::cout << "Benchmark report written to " << path << std::endl;
+    }
+    return written;
+}
+
+bool CompareBenchReport(const std::string &baselinePath, const FrameProfiler &profiler, double thresholdPercent)
+{
+    std::ifstream file(baselinePath);
+    if (!file) {
+        std::cout << "Failed to open baseline " << baselinePath << std::endl;
+        return false;
+    }
+    bool passed = true;
+    int compared = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        char name[64], kind[8];
+        TimingStats base;
+        const char *entry = strstr(line.c_str(), "{\"pass\"");
+        if (!entry || sscanf(entry, "{\"pass\": \"%63[^\"]\", \"kind\": \"%7[^\"]\", \"mean\": %f, \"p50\": %f, \"p95\": %f, \"p99\": %f",
+                             name, kind, &base.mean, &base.p50, &base.p95, &base.p99) != 6) {
+            continue;
+        }
+        for (int pass = 0; pass < profiler.PassCount(); ++pass) {
+            TimingStats current;
+            if (profiler.PassName(pass) != name || !profiler.Stats(pass, !strcmp(kind, "gpu"), current)) {
+                continue;
+            }
+            float meanChange = base.mean > 0.0f ? 100.0f * (current.mean / base.mean - 1.0f) : 0.0f;
+            float p95Change = base.p95 > 0.0f ? 100.0f * (current.p95 / base.p95 - 1.0f) : 0.0f;
+            //sub-10us passes are all timer noise
+            bool regressed = (meanChange > thresholdPercent && current.mean - base.mean > 0.01f) ||
+                             (p95Change > thresholdPercent && current.p95 - base.p95 > 0.01f);
+            printf("%-14s %s  mean %8.3f -> %8.3f (%+6.1f%%)  p95 %8.3f -> %8.3f (%+6.1f%%)%s\n", name, kind,
+                   base.mean, current.mean, meanChange, base.p95, current.p95, p95Change, regressed ? "  REGRESSION" : "");
+            passed = passed && !regressed;
+            ++compared;
+        }
+    }
+    if (compared == 0) {
+        std::cout << "Baseline " << baselinePath << " has no timings of these passes" << std::endl;
+        return false;
+    }
+    std::cout << (passed ? "No regressions" : "Slower than the baseline") << " (threshold " << thresholdPercent << "%)" << std::endl;
+    return passed;
+}
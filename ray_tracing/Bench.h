@@ -0,0 +1,19 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <string>
+
+#include "Profiler.h"
+
+//Benchmark report: mean/p50/p95/p99 in ms of every profiler pass, CPU and GPU,
+//one JSON object per line so a stored report can be read back without a parser:
+//{"pass": "frame", "kind": "cpu", "mean": 12.3, "p50": 12.1, "p95": 13.0, "p99": 14.2}
+//extra holds more members of the top-level object, e.g. "name": {...}
+bool WriteBenchReport(const std::string &path, const FrameProfiler &profiler, int width, int height, int frames,
+                      const std::string &extra = "");
+
+//compares the means and p95 of the current run with a stored report;
+//false when any of them is more than thresholdPercent slower
+bool CompareBenchReport(const std::string &baselinePath, const FrameProfiler &profiler, double thresholdPercent);
+
+#endif
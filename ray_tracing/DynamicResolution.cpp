@@ -0,0 +1,102 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+bool DynamicResolution::Init(int newWidth, int newHeight)
+{
+    Release();
+    width = newWidth;
+    height = newHeight;
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+    if (!complete) {
+        std::cout << "Failed to create the dynamic resolution target" << std::endl;
+        Release();
+        return false;
+    }
+    glGenQueries(4, queries[0]);
+    issued[0] = issued[1] = false;
+    SetScale(scale);
+    return true;
+}
+
+void DynamicResolution::Release()
+{
+    if (fbo) {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &colorBuffer);
+        fbo = colorBuffer = 0;
+    }
+    if (queries[0][0]) {
+        glDeleteQueries(4, queries[0]);
+        queries[0][0] = queries[0][1] = queries[1][0] = queries[1][1] = 0;
+    }
+}
+
+void DynamicResolution::SetScale(float newScale)
+{
+    scale = std::min(std::max(newScale, minScale), 1.0f);
+    //whole blocks of 8 pixels, so that small changes of the scale keep the size
+    renderWidth = std::max(8, std::min(width, ((int)(width * scale) + 7) / 8 * 8));
+    renderHeight = std::max(8, std::min(height, ((int)(height * scale) + 7) / 8 * 8));
+}
+
+void DynamicResolution::Begin()
+{
+    glQueryCounter(queries[parity][0], GL_TIMESTAMP);
+    issueTime[parity] = std::chrono::steady_clock::now();
+}
+
+void DynamicResolution::End()
+{
+    glQueryCounter(queries[parity][1], GL_TIMESTAMP);
+    drawnWidth = renderWidth;
+    drawnHeight = renderHeight;
+    issued[parity] = true;
+    issueScale[parity] = scale;
+    parity ^= 1;
+    if (!issued[parity]) {
+        return;
+    }
+    GLuint64 start = 0, end = 0;
+    glGetQueryObjectui64v(queries[parity][0], GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(queries[parity][1], GL_QUERY_RESULT, &end);
+    issued[parity] = false;
+    //a pass cannot take longer than the time since it was issued
+    float ms = end > start ? (end - start) / 1e6f : 0.0f;
+    float wallMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - issueTime[parity]).count();
+    if (ms <= 0.0f || ms > wallMs) {
+        return;
+    }
+    lastMs = ms;
+    float target = issueScale[parity] * std::sqrt(budgetMs / ms);
+    //half way there per frame, and a dead band against flicker between two sizes
+    float next = scale + 0.5f * (target - scale);
+    if (std::fabs(next - scale) > 0.02f) {
+        SetScale(next);
+    }
+    if (reportInterval > 0 && ++frames % reportInterval == 0) {
+        printf("Resolution %dx%d (%.0f%%), ray march %.2f ms of %.2f ms\n", renderWidth, renderHeight, 100.0f * scale, lastMs, budgetMs);
+        fflush(stdout);
+    }
+}
+
+void DynamicResolution::Blit(GLuint target) const
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+    glBlitFramebuffer(0, 0, drawnWidth, drawnHeight, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+}
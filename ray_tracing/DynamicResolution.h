@@ -0,0 +1,72 @@
+#ifndef DYNAMICRESOLUTION_H
+#define DYNAMICRESOLUTION_H
+
+#include <chrono>
+
+#include "common.h"
+
+//Dynamic resolution for the ray marching pass: it is drawn into the corner of an
+//offscreen target at Scale() of the output size and stretched over the output with a
+//bilinear blit. The pass's GPU time moves the scale towards budgetMs. Time goes with
+//the pixel count, so the next scale is the measured one times sqrt(budget / time).
+//The time comes from a pair of GL_TIMESTAMP queries, which can sit inside the
+//profiler's GL_TIME_ELAPSED one, and is read a frame late.
+class DynamicResolution
+{
+public:
+    //the target is allocated at the output size, smaller frames use a part of it
+    bool Init(int width, int height);
+
+    void Release(); //actual destructor
+
+    GLuint Framebuffer() const { return fbo; }
+
+    //internal resolution of the current frame
+    int Width() const { return renderWidth; }
+
+    int Height() const { return renderHeight; }
+
+    int OutputWidth() const { return width; }
+
+    int OutputHeight() const { return height; }
+
+    float Scale() const { return scale; }
+
+    //timer around the pass
+    void Begin();
+
+    //stops the timer and picks the scale of the next frame from the oldest result;
+    //Width() and Height() change, Blit() keeps the size the frame was drawn at
+    void End();
+
+    //stretches the last frame over the whole of target
+    void Blit(GLuint target) const;
+
+    float budgetMs = 16.0f;
+
+    float minScale = 0.25f;
+
+    int reportInterval = 120; //frames between the console lines, 0 - none
+
+private:
+    void SetScale(float newScale);
+
+    GLuint fbo = 0;
+    GLuint colorBuffer = 0;
+    GLuint queries[2][2] = {{0, 0}, {0, 0}}; //start and end of even and odd frames
+    bool issued[2] = {false, false};
+    float issueScale[2] = {1.0f, 1.0f};
+    std::chrono::steady_clock::time_point issueTime[2];
+    int parity = 0;
+    int width = 0;
+    int height = 0;
+    int renderWidth = 0;
+    int renderHeight = 0;
+    int drawnWidth = 0;
+    int drawnHeight = 0;
+    float scale = 1.0f;
+    float lastMs = 0.0f;
+    int frames = 0;
+};
+
+#endif
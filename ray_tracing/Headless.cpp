@@ -0,0 +1,282 @@
+#include "Headless.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#ifdef HAVE_EGL
+static bool HasEGLExtension(const char *extensions, const char *name)
+{
+    if (!extensions) {
+        return false;
+    }
+    size_t length = strlen(name);
+    for (const char *found = strstr(extensions, name); found; found = strstr(found + length, name)) {
+        if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static EGLDisplay OpenDisplay()
+{
+    const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (HasEGLExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay) {
+            EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+            if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL)) {
+                return display;
+            }
+        }
+    }
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL)) {
+        return display;
+    }
+    return EGL_NO_DISPLAY;
+}
+#endif
+
+bool HeadlessContext::Init(int newWidth, int newHeight)
+{
+#ifdef HAVE_EGL
+    width = newWidth;
+    height = newHeight;
+    EGLDisplay eglDisplay = OpenDisplay();
+    if (eglDisplay == EGL_NO_DISPLAY) {
+        std::cout << "Failed to open an EGL display" << std::endl;
+        return false;
+    }
+    display = eglDisplay;
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(eglDisplay, configAttribs, &config, 1, &configCount) || configCount == 0 || !eglBindAPI(EGL_OPENGL_API)) {
+        std::cout << "No EGL config for desktop OpenGL" << std::endl;
+        Release();
+        return false;
+    }
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        std::cout << "Failed to create an OpenGL 3.3 core context" << std::endl;
+        context = nullptr;
+        Release();
+        return false;
+    }
+    if (!HasEGLExtension(eglQueryString(eglDisplay, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+        const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        surface = eglCreatePbufferSurface(eglDisplay, config, pbufferAttribs);
+        if (surface == EGL_NO_SURFACE) {
+            surface = nullptr;
+        }
+    }
+    EGLSurface eglSurface = surface ? (EGLSurface)surface : EGL_NO_SURFACE;
+    if (!eglMakeCurrent(eglDisplay, eglSurface, eglSurface, (EGLContext)context)) {
+        std::cout << "Failed to make the EGL context current" << std::endl;
+        Release();
+        return false;
+    }
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cout << "Failed to initialize OpenGL context" << std::endl;
+        Release();
+        return false;
+    }
+
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "Offscreen framebuffer is incomplete: " << status << std::endl;
+        Release();
+        return false;
+    }
+    return true;
+#else
+    std::cout << "Headless mode needs EGL, this build has none" << std::endl;
+    return false;
+#endif
+}
+
+void HeadlessContext::Release()
+{
+#ifdef HAVE_EGL
+    if (fbo) {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &colorBuffer);
+        glDeleteRenderbuffers(1, &depthBuffer);
+        fbo = colorBuffer = depthBuffer = 0;
+    }
+    if (display) {
+        eglMakeCurrent((EGLDisplay)display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (surface) {
+            eglDestroySurface((EGLDisplay)display, (EGLSurface)surface);
+        }
+        if (context) {
+            eglDestroyContext((EGLDisplay)display, (EGLContext)context);
+        }
+        eglTerminate((EGLDisplay)display);
+    }
+#endif
+    display = context = surface = nullptr;
+}
+
+void HeadlessContext::ReadPixels(std::vector<unsigned char> &rgb) const
+{
+    std::vector<unsigned char> rows((size_t)width * height * 3);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rows.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    rgb.resize(rows.size());
+    size_t stride = (size_t)width * 3;
+    for (int y = 0; y < height; ++y) {
+        memcpy(&rgb[y * stride], &rows[(height - 1 - y) * stride], stride);
+    }
+}
+
+bool ReadbackRing::Init(int newWidth, int newHeight, int size)
+{
+    width = newWidth;
+    height = newHeight;
+    buffers.resize(size);
+    for (Slot &slot : buffers) {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 3, nullptr, GL_STREAM_READ);
+        slot.fence = 0;
+        slot.frame = -1;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    first = busy = 0;
+    return glGetError() == GL_NO_ERROR;
+}
+
+void ReadbackRing::Release()
+{
+    for (Slot &slot : buffers) {
+        if (slot.fence) {
+            glDeleteSync(slot.fence);
+        }
+        glDeleteBuffers(1, &slot.pbo);
+    }
+    buffers.clear();
+    first = busy = 0;
+}
+
+void ReadbackRing::Start(GLuint fbo, int frame)
+{
+    Slot &slot = buffers[(first + busy) % buffers.size()];
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.frame = frame;
+    glFlush();
+    ++busy;
+}
+
+bool ReadbackRing::Take(std::vector<unsigned char> &rgb, int &frame, bool wait)
+{
+    if (busy == 0) {
+        return false;
+    }
+    Slot &slot = buffers[first];
+    GLenum state = glClientWaitSync(slot.fence, 0, 0);
+    while (wait && state == GL_TIMEOUT_EXPIRED) {
+        state = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    }
+    if (state == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = 0;
+    size_t stride = (size_t)width * 3;
+    rgb.resize(stride * height);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const unsigned char *rows = (const unsigned char *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, stride * height, GL_MAP_READ_BIT);
+    if (rows) {
+        for (int y = 0; y < height; ++y) {
+            memcpy(&rgb[y * stride], &rows[(height - 1 - y) * stride], stride);
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        std::cout << "Failed to map the pixels of frame " << slot.frame << std::endl;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    frame = slot.frame;
+    first = (first + 1) % buffers.size();
+    --busy;
+    return rows != nullptr;
+}
+
+//creates every missing directory of the path
+static void MakeDirectory(const std::string &path)
+{
+    for (size_t slash = path.find_first_of("/\\", 1); ; slash = path.find_first_of("/\\", slash + 1)) {
+        std::string part = path.substr(0, slash);
+#ifdef _WIN32
+        _mkdir(part.c_str());
+#else
+        mkdir(part.c_str(), 0755);
+#endif
+        if (slash == std::string::npos) {
+            break;
+        }
+    }
+}
+
+bool WritePPM(const std::string &path, int width, int height, const unsigned char *rgb)
+{
+    size_t slash = path.find_last_of("/\\");
+    if (slash != std::string::npos && slash > 0) {
+        MakeDirectory(path.substr(0, slash));
+    }
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cout << "Failed to write " << path << std::endl;
+        return false;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    size_t size = (size_t)width * height * 3;
+    bool written = fwrite(rgb, 1, size, file) == size;
+    fclose(file);
+    return written;
+}
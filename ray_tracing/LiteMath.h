@@ -5,6 +5,32 @@
 #include <memory>
 #include <vector>
 
+// Constructors and the operations without transcendental functions are constexpr,
+// so transforms and scene tables built from them fold at compile time.
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define LITEMATH_HAS_CONSTANT_EVALUATED 1
+#endif
+#endif
+#if !defined(LITEMATH_HAS_CONSTANT_EVALUATED) && ((defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925))
+#define LITEMATH_HAS_CONSTANT_EVALUATED 1
+#endif
+
+// LITEMATH_USE_SSE switches float3/float4/float4x4 arithmetic to an SSE2 backend.
+// The API is the same; float4 and float4x4 become 16-byte aligned and float3 is
+// padded to 4 floats so it can be loaded into one register (the 4th lane is unspecified).
+// At compile time the SSE operations take the scalar path, which needs
+// __builtin_is_constant_evaluated; without it the backend stays scalar.
+#if defined(LITEMATH_USE_SSE) && defined(LITEMATH_HAS_CONSTANT_EVALUATED) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define LITEMATH_SSE 1
+#include <emmintrin.h>
+#define LITEMATH_ALIGN alignas(16)
+#define LITEMATH_SSE_RETURN(...) if (!__builtin_is_constant_evaluated()) return __VA_ARGS__
+#else
+#define LITEMATH_ALIGN
+#define LITEMATH_SSE_RETURN(...)
+#endif
+
 #ifdef min
 #undef min
 #endif
@@ -18,34 +44,37 @@ namespace LiteMath
 
   struct float2
   {
-    float2() :x(0), y(0) {}
-    float2(float a, float b) : x(a), y(b) {}
+    constexpr float2() :x(0), y(0) {}
+    constexpr float2(float a, float b) : x(a), y(b) {}
 
     float x, y;
   };
 
-  struct float3
+  struct LITEMATH_ALIGN float3
   {
-    float3() :x(0), y(0), z(0) {}
-    float3(float a, float b, float c) : x(a), y(b), z(c) {}
-    float3(const float* ptr) : x(ptr[0]), y(ptr[1]), z(ptr[0]) {}
+    constexpr float3() :x(0), y(0), z(0) {}
+    constexpr float3(float a, float b, float c) : x(a), y(b), z(c) {}
+    constexpr float3(const float* ptr) : x(ptr[0]), y(ptr[1]), z(ptr[0]) {}
 
     float x, y, z;
+#ifdef LITEMATH_SSE
+    float pad = 0.0f;
+#endif
   };
 
-  struct float4
+  struct LITEMATH_ALIGN float4
   {
-    float4() : x(0), y(0), z(0), w(0) {}
-    float4(float a, float b, float c, float d) : x(a), y(b), z(c), w(d) {}
+    constexpr float4() : x(0), y(0), z(0), w(0) {}
+    constexpr float4(float a, float b, float c, float d) : x(a), y(b), z(c), w(d) {}
 
     float x, y, z, w;
   };
 
   struct int3
   {
-    int3() :x(0), y(0), z(0) {}
-    int3(int a, int b, int c) : x(a), y(b), z(c) {}
-    int3(const int* ptr) : x(ptr[0]), y(ptr[1]), z(ptr[0]) {}
+    constexpr int3() :x(0), y(0), z(0) {}
+    constexpr int3(int a, int b, int c) : x(a), y(b), z(c) {}
+    constexpr int3(const int* ptr) : x(ptr[0]), y(ptr[1]), z(ptr[0]) {}
 
     int x, y, z;
   };
@@ -53,17 +82,14 @@ namespace LiteMath
 
   struct float4x4
   {
-    float4x4() { identity(); }
+    constexpr float4x4() : row{float4(1, 0, 0, 0), float4(0, 1, 0, 0), float4(0, 0, 1, 0), float4(0, 0, 0, 1)} {}
 
-    float4x4(const float arr[16])
-    {
-      row[0] = float4(arr[0], arr[1], arr[2], arr[3]);
-      row[1] = float4(arr[4], arr[5], arr[6], arr[7]);
-      row[2] = float4(arr[8], arr[9], arr[10], arr[11]);
-      row[3] = float4(arr[12], arr[13], arr[14], arr[15]);
-    }
+    constexpr float4x4(const float arr[16]) : row{float4(arr[0], arr[1], arr[2], arr[3]),
+                                                  float4(arr[4], arr[5], arr[6], arr[7]),
+                                                  float4(arr[8], arr[9], arr[10], arr[11]),
+                                                  float4(arr[12], arr[13], arr[14], arr[15])} {}
 
-    void identity()
+    constexpr void identity()
     {
       row[0] = float4(1, 0, 0, 0);
       row[1] = float4(0, 1, 0, 0);
@@ -84,58 +110,58 @@ namespace LiteMath
 
   struct uchar4
   {
-    uchar4() :x(0), y(0), z(0), w(0) {}
-    uchar4(unsigned char a, unsigned char b, unsigned char c, unsigned char d) : x(a), y(b), z(c), w(d) {}
+    constexpr uchar4() :x(0), y(0), z(0), w(0) {}
+    constexpr uchar4(unsigned char a, unsigned char b, unsigned char c, unsigned char d) : x(a), y(b), z(c), w(d) {}
 
     unsigned char x, y, z, w;
   };
 
   struct uint4
   {
-    uint4() :x(0), y(0), z(0), w(0) {}
-    uint4(unsigned int a, unsigned int b, unsigned int c, unsigned int d) : x(a), y(b), z(c), w(d) {}
+    constexpr uint4() :x(0), y(0), z(0), w(0) {}
+    constexpr uint4(unsigned int a, unsigned int b, unsigned int c, unsigned int d) : x(a), y(b), z(c), w(d) {}
 
     unsigned int x, y, z, w;
   };
 
   struct int4
   {
-    int4() :x(0), y(0), z(0), w(0) {}
-    int4(int a, int b, int c, int d) : x(a), y(b), z(c), w(d) {}
+    constexpr int4() :x(0), y(0), z(0), w(0) {}
+    constexpr int4(int a, int b, int c, int d) : x(a), y(b), z(c), w(d) {}
 
     int x, y, z, w;
   };
 
-  static inline int4 make_int4(int a, int b, int c, int d) { int4 res; res.x = a; res.y = b; res.z = c; res.w = d; return res; }
+  static inline constexpr int4 make_int4(int a, int b, int c, int d) { int4 res; res.x = a; res.y = b; res.z = c; res.w = d; return res; }
 
   struct ushort2
   {
-    ushort2() : x(0), y(0) {}
-    ushort2(unsigned short a, unsigned short b) : x(a), y(b) {}
+    constexpr ushort2() : x(0), y(0) {}
+    constexpr ushort2(unsigned short a, unsigned short b) : x(a), y(b) {}
 
     unsigned short x, y;
   };
 
   struct ushort4
   {
-    ushort4() :x(0), y(0), z(0), w(0) {}
-    ushort4(unsigned short a, unsigned short b, unsigned short c, unsigned short d) : x(a), y(b), z(c), w(d) {}
+    constexpr ushort4() :x(0), y(0), z(0), w(0) {}
+    constexpr ushort4(unsigned short a, unsigned short b, unsigned short c, unsigned short d) : x(a), y(b), z(c), w(d) {}
 
     unsigned short x, y, z, w;
   };
 
   struct int2
   {
-    int2() : x(0), y(0) {}
-    int2(int a, int b) : x(a), y(b) {}
+    constexpr int2() : x(0), y(0) {}
+    constexpr int2(int a, int b) : x(a), y(b) {}
 
     int x, y;
   };
 
   struct uint2
   {
-    uint2() : x(0), y(0) {}
-    uint2(unsigned int a, unsigned int b) : x(a), y(b) {}
+    constexpr uint2() : x(0), y(0) {}
+    constexpr uint2(unsigned int a, unsigned int b) : x(a), y(b) {}
 
     unsigned int x, y;
   };
@@ -150,49 +176,62 @@ namespace LiteMath
   }
 
   static inline float clamp(float u, float a, float b) { float r = fmax(a, u); return fmin(r, b); }
-  static inline int   clamp(int u, int a, int b) { int r = (a > u) ? a : u; return (r < b) ? r : b; }
+  static inline constexpr int clamp(int u, int a, int b) { int r = (a > u) ? a : u; return (r < b) ? r : b; }
 
-  static inline int max(int a, int b) { return a > b ? a : b; }
-  static inline int min(int a, int b) { return a < b ? a : b; }
+  static inline constexpr int max(int a, int b) { return a > b ? a : b; }
+  static inline constexpr int min(int a, int b) { return a < b ? a : b; }
 
 
   #define SQR(x) ((x)*(x))
 
-  static inline float4 make_float4(float a, float b, float c, float d) { return float4(a, b, c, d); }
-  static inline float3 make_float3(float a, float b, float c) { return float3(a, b, c); }
-  static inline float2 make_float2(float a, float b) { return float2(a, b); }
+  static inline constexpr float4 make_float4(float a, float b, float c, float d) { return float4(a, b, c, d); }
+  static inline constexpr float3 make_float3(float a, float b, float c) { return float3(a, b, c); }
+  static inline constexpr float2 make_float2(float a, float b) { return float2(a, b); }
 
-  static inline float2 to_float2(float4 v) { return make_float2(v.x, v.y); }
-  static inline float2 to_float2(float3 v) { return make_float2(v.x, v.y); }
-  static inline float3 to_float3(float4 v) { return make_float3(v.x, v.y, v.z); }
-  static inline float4 to_float4(float3 v, float w) { return make_float4(v.x, v.y, v.z, w); }
+  static inline constexpr float2 to_float2(float4 v) { return make_float2(v.x, v.y); }
+  static inline constexpr float2 to_float2(float3 v) { return make_float2(v.x, v.y); }
+  static inline constexpr float3 to_float3(float4 v) { return make_float3(v.x, v.y, v.z); }
+  static inline constexpr float4 to_float4(float3 v, float w) { return make_float4(v.x, v.y, v.z, w); }
 
   //**********************************************************************************
   // float4 operators and functions
   //**********************************************************************************
-  static inline float4 operator * (const float4 & u, float v) { return make_float4(u.x * v, u.y * v, u.z * v, u.w * v); }
-  static inline float4 operator / (const float4 & u, float v) { return make_float4(u.x / v, u.y / v, u.z / v, u.w / v); }
-  static inline float4 operator * (float v, const float4 & u) { return make_float4(v * u.x, v * u.y, v * u.z, v * u.w); }
-  static inline float4 operator / (float v, const float4 & u) { return make_float4(v / u.x, v / u.y, v / u.z, v / u.w); }
+#ifdef LITEMATH_SSE
+  // built from the fields instead of one aligned load, so a float4 assembled from scalars stays in registers
+  static inline __m128 load_m128(const float4 & u) { return _mm_setr_ps(u.x, u.y, u.z, u.w); }
+  static inline float4 store_float4(__m128 r) { float4 res; _mm_store_ps(&res.x, r); return res; }
+
+  static inline float hsum_m128(__m128 r)
+  {
+    r = _mm_add_ps(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 3, 0, 1)));
+    r = _mm_add_ss(r, _mm_movehl_ps(r, r));
+    return _mm_cvtss_f32(r);
+  }
+#endif
 
-  static inline float4 operator + (const float4 & u, const float4 & v) { return make_float4(u.x + v.x, u.y + v.y, u.z + v.z, u.w + v.w); }
-  static inline float4 operator - (const float4 & u, const float4 & v) { return make_float4(u.x - v.x, u.y - v.y, u.z - v.z, u.w - v.w); }
-  static inline float4 operator * (const float4 & u, const float4 & v) { return make_float4(u.x * v.x, u.y * v.y, u.z * v.z, u.w * v.w); }
-  static inline float4 operator / (const float4 & u, const float4 & v) { return make_float4(u.x / v.x, u.y / v.y, u.z / v.z, u.w / v.w); }
+  static inline constexpr float4 operator * (const float4 & u, float v) { LITEMATH_SSE_RETURN(store_float4(_mm_mul_ps(load_m128(u), _mm_set1_ps(v)))); return make_float4(u.x * v, u.y * v, u.z * v, u.w * v); }
+  static inline constexpr float4 operator / (const float4 & u, float v) { LITEMATH_SSE_RETURN(store_float4(_mm_div_ps(load_m128(u), _mm_set1_ps(v)))); return make_float4(u.x / v, u.y / v, u.z / v, u.w / v); }
+  static inline constexpr float4 operator * (float v, const float4 & u) { LITEMATH_SSE_RETURN(store_float4(_mm_mul_ps(_mm_set1_ps(v), load_m128(u)))); return make_float4(v * u.x, v * u.y, v * u.z, v * u.w); }
+  static inline constexpr float4 operator / (float v, const float4 & u) { LITEMATH_SSE_RETURN(store_float4(_mm_div_ps(_mm_set1_ps(v), load_m128(u)))); return make_float4(v / u.x, v / u.y, v / u.z, v / u.w); }
 
-  static inline float4 & operator += (float4 & u, const float4 & v) { u.x += v.x; u.y += v.y; u.z += v.z; u.w += v.w; return u; }
-  static inline float4 & operator -= (float4 & u, const float4 & v) { u.x -= v.x; u.y -= v.y; u.z -= v.z; u.w -= v.w; return u; }
-  static inline float4 & operator *= (float4 & u, const float4 & v) { u.x *= v.x; u.y *= v.y; u.z *= v.z; u.w *= v.w; return u; }
-  static inline float4 & operator /= (float4 & u, const float4 & v) { u.x /= v.x; u.y /= v.y; u.z /= v.z; u.w /= v.w; return u; }
+  static inline constexpr float4 operator + (const float4 & u, const float4 & v) { LITEMATH_SSE_RETURN(store_float4(_mm_add_ps(load_m128(u), load_m128(v)))); return make_float4(u.x + v.x, u.y + v.y, u.z + v.z, u.w + v.w); }
+  static inline constexpr float4 operator - (const float4 & u, const float4 & v) { LITEMATH_SSE_RETURN(store_float4(_mm_sub_ps(load_m128(u), load_m128(v)))); return make_float4(u.x - v.x, u.y - v.y, u.z - v.z, u.w - v.w); }
+  static inline constexpr float4 operator * (const float4 & u, const float4 & v) { LITEMATH_SSE_RETURN(store_float4(_mm_mul_ps(load_m128(u), load_m128(v)))); return make_float4(u.x * v.x, u.y * v.y, u.z * v.z, u.w * v.w); }
+  static inline constexpr float4 operator / (const float4 & u, const float4 & v) { LITEMATH_SSE_RETURN(store_float4(_mm_div_ps(load_m128(u), load_m128(v)))); return make_float4(u.x / v.x, u.y / v.y, u.z / v.z, u.w / v.w); }
 
-  static inline float4 & operator += (float4 & u, float v) { u.x += v; u.y += v; u.z += v; u.w += v; return u; }
-  static inline float4 & operator -= (float4 & u, float v) { u.x -= v; u.y -= v; u.z -= v; u.w -= v; return u; }
-  static inline float4 & operator *= (float4 & u, float v) { u.x *= v; u.y *= v; u.z *= v; u.w *= v; return u; }
-  static inline float4 & operator /= (float4 & u, float v) { u.x /= v; u.y /= v; u.z /= v; u.w /= v; return u; }
+  static inline constexpr float4 & operator += (float4 & u, const float4 & v) { u.x += v.x; u.y += v.y; u.z += v.z; u.w += v.w; return u; }
+  static inline constexpr float4 & operator -= (float4 & u, const float4 & v) { u.x -= v.x; u.y -= v.y; u.z -= v.z; u.w -= v.w; return u; }
+  static inline constexpr float4 & operator *= (float4 & u, const float4 & v) { u.x *= v.x; u.y *= v.y; u.z *= v.z; u.w *= v.w; return u; }
+  static inline constexpr float4 & operator /= (float4 & u, const float4 & v) { u.x /= v.x; u.y /= v.y; u.z /= v.z; u.w /= v.w; return u; }
 
-  static inline float4   operator - (const float4 & v) { return make_float4(-v.x, -v.y, -v.z, -v.w); }
+  static inline constexpr float4 & operator += (float4 & u, float v) { u.x += v; u.y += v; u.z += v; u.w += v; return u; }
+  static inline constexpr float4 & operator -= (float4 & u, float v) { u.x -= v; u.y -= v; u.z -= v; u.w -= v; return u; }
+  static inline constexpr float4 & operator *= (float4 & u, float v) { u.x *= v; u.y *= v; u.z *= v; u.w *= v; return u; }
+  static inline constexpr float4 & operator /= (float4 & u, float v) { u.x /= v; u.y /= v; u.z /= v; u.w /= v; return u; }
 
-  static inline float4 catmullrom(const float4 & P0, const float4 & P1, const float4 & P2, const float4 & P3, float t)
+  static inline constexpr float4   operator - (const float4 & v) { return make_float4(-v.x, -v.y, -v.z, -v.w); }
+
+  static inline constexpr float4 catmullrom(const float4 & P0, const float4 & P1, const float4 & P2, const float4 & P3, float t)
   {
     const float ts = t * t;
     const float tc = t * ts;
@@ -200,10 +239,10 @@ namespace LiteMath
     return (P0 * (-tc + 2.0f * ts - t) + P1 * (3.0f * tc - 5.0f * ts + 2.0f) + P2 * (-3.0f * tc + 4.0f * ts + t) + P3 * (tc - ts)) * 0.5f;
   }
 
-  static inline float4 lerp(const float4 & u, const float4 & v, float t) { return u + t * (v - u); }
-  static inline float  dot(const float4 & u, const float4 & v) { return (u.x*v.x + u.y*v.y + u.z*v.z + u.w*v.w); }
-  static inline float  dot3(const float4 & u, const float4 & v) { return (u.x*v.x + u.y*v.y + u.z*v.z); }
-  static inline float  dot3(const float4 & u, const float3 & v) { return (u.x*v.x + u.y*v.y + u.z*v.z); }
+  static inline constexpr float4 lerp(const float4 & u, const float4 & v, float t) { return u + t * (v - u); }
+  static inline constexpr float dot(const float4 & u, const float4 & v) { LITEMATH_SSE_RETURN(hsum_m128(_mm_mul_ps(load_m128(u), load_m128(v)))); return (u.x*v.x + u.y*v.y + u.z*v.z + u.w*v.w); }
+  static inline constexpr float  dot3(const float4 & u, const float4 & v) { return (u.x*v.x + u.y*v.y + u.z*v.z); }
+  static inline constexpr float  dot3(const float4 & u, const float3 & v) { return (u.x*v.x + u.y*v.y + u.z*v.z); }
 
   static inline float4 clamp(const float4 & u, float a, float b) { return make_float4(clamp(u.x, a, b), clamp(u.y, a, b), clamp(u.z, a, b), clamp(u.w, a, b)); }
 
@@ -215,30 +254,35 @@ namespace LiteMath
   //**********************************************************************************
   // float3 operators and functions
   //**********************************************************************************
-  static inline float3 operator * (const float3 & u, float v) { return make_float3(u.x * v, u.y * v, u.z * v); }
-  static inline float3 operator / (const float3 & u, float v) { return make_float3(u.x / v, u.y / v, u.z / v); }
-  static inline float3 operator * (float v, const float3 & u) { return make_float3(v * u.x, v * u.y, v * u.z); }
-  static inline float3 operator / (float v, const float3 & u) { return make_float3(v / u.x, v / u.y, v / u.z); }
+#ifdef LITEMATH_SSE
+  static inline __m128 load_m128(const float3 & u) { return _mm_setr_ps(u.x, u.y, u.z, u.pad); }
+  static inline float3 store_float3(__m128 r) { float3 res; _mm_store_ps(&res.x, r); return res; }
+#endif
 
-  static inline float3 operator + (const float3 & u, const float3 & v) { return make_float3(u.x + v.x, u.y + v.y, u.z + v.z); }
-  static inline float3 operator - (const float3 & u, const float3 & v) { return make_float3(u.x - v.x, u.y - v.y, u.z - v.z); }
-  static inline float3 operator * (const float3 & u, const float3 & v) { return make_float3(u.x * v.x, u.y * v.y, u.z * v.z); }
-  static inline float3 operator / (const float3 & u, const float3 & v) { return make_float3(u.x / v.x, u.y / v.y, u.z / v.z); }
+  static inline constexpr float3 operator * (const float3 & u, float v) { LITEMATH_SSE_RETURN(store_float3(_mm_mul_ps(load_m128(u), _mm_set1_ps(v)))); return make_float3(u.x * v, u.y * v, u.z * v); }
+  static inline constexpr float3 operator / (const float3 & u, float v) { LITEMATH_SSE_RETURN(store_float3(_mm_div_ps(load_m128(u), _mm_set1_ps(v)))); return make_float3(u.x / v, u.y / v, u.z / v); }
+  static inline constexpr float3 operator * (float v, const float3 & u) { LITEMATH_SSE_RETURN(store_float3(_mm_mul_ps(_mm_set1_ps(v), load_m128(u)))); return make_float3(v * u.x, v * u.y, v * u.z); }
+  static inline constexpr float3 operator / (float v, const float3 & u) { LITEMATH_SSE_RETURN(store_float3(_mm_div_ps(_mm_set1_ps(v), load_m128(u)))); return make_float3(v / u.x, v / u.y, v / u.z); }
 
-  static inline float3 operator - (const float3 & u) { return make_float3(-u.x, -u.y, -u.z); }
+  static inline constexpr float3 operator + (const float3 & u, const float3 & v) { LITEMATH_SSE_RETURN(store_float3(_mm_add_ps(load_m128(u), load_m128(v)))); return make_float3(u.x + v.x, u.y + v.y, u.z + v.z); }
+  static inline constexpr float3 operator - (const float3 & u, const float3 & v) { LITEMATH_SSE_RETURN(store_float3(_mm_sub_ps(load_m128(u), load_m128(v)))); return make_float3(u.x - v.x, u.y - v.y, u.z - v.z); }
+  static inline constexpr float3 operator * (const float3 & u, const float3 & v) { LITEMATH_SSE_RETURN(store_float3(_mm_mul_ps(load_m128(u), load_m128(v)))); return make_float3(u.x * v.x, u.y * v.y, u.z * v.z); }
+  static inline constexpr float3 operator / (const float3 & u, const float3 & v) { LITEMATH_SSE_RETURN(store_float3(_mm_div_ps(load_m128(u), load_m128(v)))); return make_float3(u.x / v.x, u.y / v.y, u.z / v.z); }
 
-  static inline float3 & operator += (float3 & u, const float3 & v) { u.x += v.x; u.y += v.y; u.z += v.z; return u; }
-  static inline float3 & operator -= (float3 & u, const float3 & v) { u.x -= v.x; u.y -= v.y; u.z -= v.z; return u; }
-  static inline float3 & operator *= (float3 & u, const float3 & v) { u.x *= v.x; u.y *= v.y; u.z *= v.z; return u; }
-  static inline float3 & operator /= (float3 & u, const float3 & v) { u.x /= v.x; u.y /= v.y; u.z /= v.z; return u; }
+  static inline constexpr float3 operator - (const float3 & u) { return make_float3(-u.x, -u.y, -u.z); }
 
-  static inline float3 & operator += (float3 & u, float v) { u.x += v; u.y += v; u.z += v; return u; }
-  static inline float3 & operator -= (float3 & u, float v) { u.x -= v; u.y -= v; u.z -= v; return u; }
-  static inline float3 & operator *= (float3 & u, float v) { u.x *= v; u.y *= v; u.z *= v; return u; }
-  static inline float3 & operator /= (float3 & u, float v) { u.x /= v; u.y /= v; u.z /= v; return u; }
+  static inline constexpr float3 & operator += (float3 & u, const float3 & v) { u.x += v.x; u.y += v.y; u.z += v.z; return u; }
+  static inline constexpr float3 & operator -= (float3 & u, const float3 & v) { u.x -= v.x; u.y -= v.y; u.z -= v.z; return u; }
+  static inline constexpr float3 & operator *= (float3 & u, const float3 & v) { u.x *= v.x; u.y *= v.y; u.z *= v.z; return u; }
+  static inline constexpr float3 & operator /= (float3 & u, const float3 & v) { u.x /= v.x; u.y /= v.y; u.z /= v.z; return u; }
 
+  static inline constexpr float3 & operator += (float3 & u, float v) { u.x += v; u.y += v; u.z += v; return u; }
+  static inline constexpr float3 & operator -= (float3 & u, float v) { u.x -= v; u.y -= v; u.z -= v; return u; }
+  static inline constexpr float3 & operator *= (float3 & u, float v) { u.x *= v; u.y *= v; u.z *= v; return u; }
+  static inline constexpr float3 & operator /= (float3 & u, float v) { u.x /= v; u.y /= v; u.z /= v; return u; }
 
-  static inline float3 catmullrom(const float3 & P0, const float3 & P1, const float3 & P2, const float3 & P3, float t)
+
+  static inline constexpr float3 catmullrom(const float3 & P0, const float3 & P1, const float3 & P2, const float3 & P3, float t)
   {
     const float ts = t * t;
     const float tc = t * ts;
@@ -246,17 +290,33 @@ namespace LiteMath
     return (P0 * (-tc + 2.0f * ts - t) + P1 * (3.0f * tc - 5.0f * ts + 2.0f) + P2 * (-3.0f * tc + 4.0f * ts + t) + P3 * (tc - ts)) * 0.5f;
   }
 
-  static inline float3 lerp(const float3 & u, const float3 & v, float t) { return u + t * (v - u); }
-  static inline float  dot(const float3 & u, const float3 & v) { return (u.x*v.x + u.y*v.y + u.z*v.z); }
-  static inline float3 cross(const float3 & u, const float3 & v) { return make_float3(u.y*v.z - u.z*v.y, u.z*v.x - u.x*v.z, u.x*v.y - u.y*v.x); }
+  static inline constexpr float3 lerp(const float3 & u, const float3 & v, float t) { return u + t * (v - u); }
+#ifdef LITEMATH_SSE
+  static inline float  dot_sse(const float3 & u, const float3 & v)
+  {
+    __m128 r = _mm_mul_ps(load_m128(u), load_m128(v));
+    r = _mm_add_ss(_mm_add_ss(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 1, 1, 1))), _mm_movehl_ps(r, r));
+    return _mm_cvtss_f32(r);
+  }
+  static inline float3 cross_sse(const float3 & u, const float3 & v)
+  {
+    const __m128 a = load_m128(u), b = load_m128(v);
+    const __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    const __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    const __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+    return store_float3(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+  }
+#endif
+  static inline constexpr float  dot(const float3 & u, const float3 & v) { LITEMATH_SSE_RETURN(dot_sse(u, v)); return (u.x*v.x + u.y*v.y + u.z*v.z); }
+  static inline constexpr float3 cross(const float3 & u, const float3 & v) { LITEMATH_SSE_RETURN(cross_sse(u, v)); return make_float3(u.y*v.z - u.z*v.y, u.z*v.x - u.x*v.z, u.x*v.y - u.y*v.x); }
   //inline float3 mul       (const float3 & u, const float3 & v) { return make_float3( u.x*v.x, u.y*v.y, u.z*v.z} ; return r; }
   static inline float3 clamp(const float3 & u, float a, float b) { return make_float3(clamp(u.x, a, b), clamp(u.y, a, b), clamp(u.z, a, b)); }
 
-  static inline float  triple(const float3 & a, const float3 & b, const float3 & c) { return dot(a, cross(b, c)); }
-  static inline float  length(const float3 & u) { return sqrtf(SQR(u.x) + SQR(u.y) + SQR(u.z)); }
-  static inline float  lengthSquare(const float3 u) { return u.x*u.x + u.y*u.y + u.z*u.z; }
+  static inline constexpr float  triple(const float3 & a, const float3 & b, const float3 & c) { return dot(a, cross(b, c)); }
+  static inline float  length(const float3 & u) { return sqrtf(dot(u, u)); }
+  static inline constexpr float lengthSquare(const float3 u) { return dot(u, u); }
   static inline float3 normalize(const float3 & u) { return u / length(u); }
-  static inline float  coordSumm(const float3 u) { return u.x* +u.y + u.z; }
+  static inline constexpr float  coordSumm(const float3 u) { return u.x* +u.y + u.z; }
   //static inline float  coordAbsMax (const float3 u) { return max(max(abs(u.x), abs(u.y)), abs(u.z)); }
 
   static inline float  maxcomp(const float3 & u) { return fmax(u.x, fmax(u.y, u.z)); }
@@ -267,29 +327,29 @@ namespace LiteMath
   // float2 operators and functions
   //**********************************************************************************
 
-  static inline float2 operator * (const float2 & u, float v) { return make_float2(u.x * v, u.y * v); }
-  static inline float2 operator / (const float2 & u, float v) { return make_float2(u.x / v, u.y / v); }
-  static inline float2 operator * (float v, const float2 & u) { return make_float2(v * u.x, v * u.y); }
-  static inline float2 operator / (float v, const float2 & u) { return make_float2(v / u.x, v / u.y); }
+  static inline constexpr float2 operator * (const float2 & u, float v) { return make_float2(u.x * v, u.y * v); }
+  static inline constexpr float2 operator / (const float2 & u, float v) { return make_float2(u.x / v, u.y / v); }
+  static inline constexpr float2 operator * (float v, const float2 & u) { return make_float2(v * u.x, v * u.y); }
+  static inline constexpr float2 operator / (float v, const float2 & u) { return make_float2(v / u.x, v / u.y); }
 
-  static inline float2 operator + (const float2 & u, const float2 & v) { return make_float2(u.x + v.x, u.y + v.y); }
-  static inline float2 operator - (const float2 & u, const float2 & v) { return make_float2(u.x - v.x, u.y - v.y); }
-  static inline float2 operator * (const float2 & u, const float2 & v) { return make_float2(u.x * v.x, u.y * v.y); }
-  static inline float2 operator / (const float2 & u, const float2 & v) { return make_float2(u.x / v.x, u.y / v.y); }
+  static inline constexpr float2 operator + (const float2 & u, const float2 & v) { return make_float2(u.x + v.x, u.y + v.y); }
+  static inline constexpr float2 operator - (const float2 & u, const float2 & v) { return make_float2(u.x - v.x, u.y - v.y); }
+  static inline constexpr float2 operator * (const float2 & u, const float2 & v) { return make_float2(u.x * v.x, u.y * v.y); }
+  static inline constexpr float2 operator / (const float2 & u, const float2 & v) { return make_float2(u.x / v.x, u.y / v.y); }
 
-  static inline float2   operator - (const float2 & v) { return make_float2(-v.x, -v.y); }
+  static inline constexpr float2   operator - (const float2 & v) { return make_float2(-v.x, -v.y); }
 
-  static inline float2 & operator += (float2 & u, const float2 & v) { u.x += v.x; u.y += v.y; return u; }
-  static inline float2 & operator -= (float2 & u, const float2 & v) { u.x -= v.x; u.y -= v.y; return u; }
-  static inline float2 & operator *= (float2 & u, const float2 & v) { u.x *= v.x; u.y *= v.y; return u; }
-  static inline float2 & operator /= (float2 & u, const float2 & v) { u.x /= v.x; u.y /= v.y; return u; }
+  static inline constexpr float2 & operator += (float2 & u, const float2 & v) { u.x += v.x; u.y += v.y; return u; }
+  static inline constexpr float2 & operator -= (float2 & u, const float2 & v) { u.x -= v.x; u.y -= v.y; return u; }
+  static inline constexpr float2 & operator *= (float2 & u, const float2 & v) { u.x *= v.x; u.y *= v.y; return u; }
+  static inline constexpr float2 & operator /= (float2 & u, const float2 & v) { u.x /= v.x; u.y /= v.y; return u; }
 
-  static inline float2 & operator += (float2 & u, float v) { u.x += v; u.y += v; return u; }
-  static inline float2 & operator -= (float2 & u, float v) { u.x -= v; u.y -= v; return u; }
-  static inline float2 & operator *= (float2 & u, float v) { u.x *= v; u.y *= v; return u; }
-  static inline float2 & operator /= (float2 & u, float v) { u.x /= v; u.y /= v; return u; }
+  static inline constexpr float2 & operator += (float2 & u, float v) { u.x += v; u.y += v; return u; }
+  static inline constexpr float2 & operator -= (float2 & u, float v) { u.x -= v; u.y -= v; return u; }
+  static inline constexpr float2 & operator *= (float2 & u, float v) { u.x *= v; u.y *= v; return u; }
+  static inline constexpr float2 & operator /= (float2 & u, float v) { u.x /= v; u.y /= v; return u; }
 
-  static inline float2 catmullrom(const float2 & P0, const float2 & P1, const float2 & P2, const float2 & P3, float t)
+  static inline constexpr float2 catmullrom(const float2 & P0, const float2 & P1, const float2 & P2, const float2 & P3, float t)
   {
     const float ts = t * t;
     const float tc = t * ts;
@@ -297,8 +357,8 @@ namespace LiteMath
     return (P0 * (-tc + 2.0f * ts - t) + P1 * (3.0f * tc - 5.0f * ts + 2.0f) + P2 * (-3.0f * tc + 4.0f * ts + t) + P3 * (tc - ts)) * 0.5f;
   }
 
-  static inline float2 lerp(const float2 & u, const float2 & v, float t) { return u + t * (v - u); }
-  static inline float  dot(const float2 & u, const float2 & v) { return (u.x*v.x + u.y*v.y); }
+  static inline constexpr float2 lerp(const float2 & u, const float2 & v, float t) { return u + t * (v - u); }
+  static inline constexpr float  dot(const float2 & u, const float2 & v) { return (u.x*v.x + u.y*v.y); }
   static inline float2 clamp(const float2 & u, float a, float b) { return make_float2(clamp(u.x, a, b), clamp(u.y, a, b)); }
 
 
@@ -306,25 +366,41 @@ namespace LiteMath
   static inline float2 normalize(const float2 & u) { return u / length(u); }
 
 
-  static inline float lerp(float u, float v, float t) { return u + t * (v - u); }
+  static inline constexpr float lerp(float u, float v, float t) { return u + t * (v - u); }
 
   //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  static inline bool IntersectBoxBox(float2 box1Min, float2 box1Max, float2 box2Min, float2 box2Max)
+  static inline constexpr bool IntersectBoxBox(float2 box1Min, float2 box1Max, float2 box2Min, float2 box2Max)
   {
     return box1Min.x <= box2Max.x && box2Min.x <= box1Max.x &&
            box1Min.y <= box2Max.y && box2Min.y <= box1Max.y;
   }
 
-  static inline bool IntersectBoxBox(int2 box1Min, int2 box1Max, int2 box2Min, int2 box2Max)
+  static inline constexpr bool IntersectBoxBox(int2 box1Min, int2 box1Max, int2 box2Min, int2 box2Max)
   {
     return box1Min.x <= box2Max.x && box2Min.x <= box1Max.x &&
            box1Min.y <= box2Max.y && box2Min.y <= box1Max.y;
   }
 
-  static inline float4 mul(float4x4 m, float4 v)
+#ifdef LITEMATH_SSE
+  static inline float4 mul_sse(const float4x4 & m, const float4 & v)
+  {
+    __m128 r0 = _mm_load_ps(&m.row[0].x), r1 = _mm_load_ps(&m.row[1].x);
+    __m128 r2 = _mm_load_ps(&m.row[2].x), r3 = _mm_load_ps(&m.row[3].x);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    const __m128 a = load_m128(v);
+    __m128 res = _mm_mul_ps(r0, _mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)));
+    res = _mm_add_ps(res, _mm_mul_ps(r1, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1))));
+    res = _mm_add_ps(res, _mm_mul_ps(r2, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2))));
+    res = _mm_add_ps(res, _mm_mul_ps(r3, _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3))));
+    return store_float4(res);
+  }
+#endif
+
+  static inline constexpr float4 mul(const float4x4 & m, const float4 & v)
   {
+    LITEMATH_SSE_RETURN(mul_sse(m, v));
     float4 res;
     res.x = m.row[0].x*v.x + m.row[0].y*v.y + m.row[0].z*v.z + m.row[0].w*v.w;
     res.y = m.row[1].x*v.x + m.row[1].y*v.y + m.row[1].z*v.z + m.row[1].w*v.w;
@@ -333,7 +409,7 @@ namespace LiteMath
     return res;
   }
 
-  static inline float3 mul(float4x4 m, float3 v)
+  static inline constexpr float3 mul(float4x4 m, float3 v)
   {
     float3 res;
     res.x = m.row[0].x*v.x + m.row[0].y*v.y + m.row[0].z*v.z + m.row[0].w;
@@ -343,7 +419,7 @@ namespace LiteMath
   }
 
 
-  static inline float3 mul4x3(float4x4 m, float3 v)
+  static inline constexpr float3 mul4x3(float4x4 m, float3 v)
   {
     float3 res;
     res.x = m.row[0].x*v.x + m.row[0].y*v.y + m.row[0].z*v.z + m.row[0].w;
@@ -352,7 +428,7 @@ namespace LiteMath
     return res;
   }
 
-  static inline float3 mul3x3(float4x4 m, float3 v)
+  static inline constexpr float3 mul3x3(float4x4 m, float3 v)
   {
     float3 res;
     res.x = m.row[0].x*v.x + m.row[0].y*v.y + m.row[0].z*v.z;
@@ -362,7 +438,7 @@ namespace LiteMath
   }
 
 
-  static inline float4x4 make_float4x4_by_columns(float4 a, float4 b, float4 c, float4 d)
+  static inline constexpr float4x4 make_float4x4_by_columns(float4 a, float4 b, float4 c, float4 d)
   {
     float4x4 m;
 
@@ -389,13 +465,48 @@ namespace LiteMath
     return m;
   }
 
-  static inline float4x4 transpose4x4(float4x4 m)
+#ifdef LITEMATH_SSE
+  static inline float4x4 transpose4x4_sse(const float4x4 & m)
+  {
+    __m128 r0 = _mm_load_ps(&m.row[0].x), r1 = _mm_load_ps(&m.row[1].x);
+    __m128 r2 = _mm_load_ps(&m.row[2].x), r3 = _mm_load_ps(&m.row[3].x);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    float4x4 res;
+    _mm_store_ps(&res.row[0].x, r0);
+    _mm_store_ps(&res.row[1].x, r1);
+    _mm_store_ps(&res.row[2].x, r2);
+    _mm_store_ps(&res.row[3].x, r3);
+    return res;
+  }
+
+  // row i of the result is sum_k m1[i][k] * m2.row[k]
+  static inline float4x4 mul_sse(const float4x4 & m1, const float4x4 & m2)
   {
+    const __m128 b0 = _mm_load_ps(&m2.row[0].x), b1 = _mm_load_ps(&m2.row[1].x);
+    const __m128 b2 = _mm_load_ps(&m2.row[2].x), b3 = _mm_load_ps(&m2.row[3].x);
+    float4x4 res;
+    for (int i = 0; i < 4; i++)
+    {
+      const __m128 a = _mm_load_ps(&m1.row[i].x);
+      __m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+      r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+      r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+      r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+      _mm_store_ps(&res.row[i].x, r);
+    }
+    return res;
+  }
+#endif
+
+  static inline constexpr float4x4 transpose4x4(const float4x4 & m)
+  {
+    LITEMATH_SSE_RETURN(transpose4x4_sse(m));
     return make_float4x4_by_columns(m.row[0], m.row[1], m.row[2], m.row[3]);
   }
 
-  static inline float4x4 mul(float4x4 m1, float4x4 m2)
+  static inline constexpr float4x4 mul(const float4x4 & m1, const float4x4 & m2)
   {
+    LITEMATH_SSE_RETURN(mul_sse(m1, m2));
     const float4 column1 = mul(m1, make_float4(m2.row[0].x, m2.row[1].x, m2.row[2].x, m2.row[3].x));
     const float4 column2 = mul(m1, make_float4(m2.row[0].y, m2.row[1].y, m2.row[2].y, m2.row[3].y));
     const float4 column3 = mul(m1, make_float4(m2.row[0].z, m2.row[1].z, m2.row[2].z, m2.row[3].z));
@@ -404,7 +515,7 @@ namespace LiteMath
     return make_float4x4_by_columns(column1, column2, column3, column4);
   }
 
-  static inline float4x4 translate4x4(float3 t)
+  static inline constexpr float4x4 translate4x4(float3 t)
   {
     const float4 column1 = make_float4(1.0f, 0.0f, 0.0f, 0.0f);
     const float4 column2 = make_float4(0.0f, 1.0f, 0.0f, 0.0f);
@@ -414,7 +525,7 @@ namespace LiteMath
     return make_float4x4_by_columns(column1, column2, column3, column4);
   }
 
-  static inline float4x4 scale4x4(float3 t)
+  static inline constexpr float4x4 scale4x4(float3 t)
   {
     const float4 column1 = make_float4( t.x, 0.0f, 0.0f, 0.0f);
     const float4 column2 = make_float4(0.0f,  t.y, 0.0f, 0.0f);
@@ -454,9 +565,79 @@ namespace LiteMath
     return make_float4x4_by_columns(column1, column2, column3, column4);
   }
 
-  static inline float4x4 inverse4x4(float4x4 m1)
+#ifdef LITEMATH_SSE
+  // block-wise inverse through 2x2 adjugates, rows are split into
+  // A = rows 0-1 cols 0-1, B = rows 0-1 cols 2-3, C = rows 2-3 cols 0-1, D = rows 2-3 cols 2-3
+  #define LITEMATH_SWIZZLE(v, x, y, z, w) _mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x))
+  #define LITEMATH_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+
+  static inline __m128 mat2_mul(__m128 a, __m128 b)
+  {
+    return _mm_add_ps(_mm_mul_ps(a, LITEMATH_SWIZZLE(b, 0, 3, 0, 3)), _mm_mul_ps(LITEMATH_SWIZZLE(a, 1, 0, 3, 2), LITEMATH_SWIZZLE(b, 2, 1, 2, 1)));
+  }
+
+  static inline __m128 mat2_adj_mul(__m128 a, __m128 b)
+  {
+    return _mm_sub_ps(_mm_mul_ps(LITEMATH_SWIZZLE(a, 3, 3, 0, 0), b), _mm_mul_ps(LITEMATH_SWIZZLE(a, 1, 1, 2, 2), LITEMATH_SWIZZLE(b, 2, 3, 0, 1)));
+  }
+
+  static inline __m128 mat2_mul_adj(__m128 a, __m128 b)
+  {
+    return _mm_sub_ps(_mm_mul_ps(a, LITEMATH_SWIZZLE(b, 3, 0, 3, 0)), _mm_mul_ps(LITEMATH_SWIZZLE(a, 1, 0, 3, 2), LITEMATH_SWIZZLE(b, 2, 1, 2, 1)));
+  }
+
+  static inline float4x4 inverse4x4_sse(const float4x4 & m1)
+  {
+    const __m128 r0 = _mm_load_ps(&m1.row[0].x), r1 = _mm_load_ps(&m1.row[1].x);
+    const __m128 r2 = _mm_load_ps(&m1.row[2].x), r3 = _mm_load_ps(&m1.row[3].x);
+
+    const __m128 A = _mm_movelh_ps(r0, r1);
+    const __m128 B = _mm_movehl_ps(r1, r0);
+    const __m128 C = _mm_movelh_ps(r2, r3);
+    const __m128 D = _mm_movehl_ps(r3, r2);
+
+    // (|A|, |B|, |C|, |D|)
+    const __m128 detSub = _mm_sub_ps(_mm_mul_ps(LITEMATH_SHUFFLE(r0, r2, 0, 2, 0, 2), LITEMATH_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+                                     _mm_mul_ps(LITEMATH_SHUFFLE(r0, r2, 1, 3, 1, 3), LITEMATH_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+    const __m128 detA = LITEMATH_SWIZZLE(detSub, 0, 0, 0, 0);
+    const __m128 detB = LITEMATH_SWIZZLE(detSub, 1, 1, 1, 1);
+    const __m128 detC = LITEMATH_SWIZZLE(detSub, 2, 2, 2, 2);
+    const __m128 detD = LITEMATH_SWIZZLE(detSub, 3, 3, 3, 3);
+
+    const __m128 D_C = mat2_adj_mul(D, C);
+    const __m128 A_B = mat2_adj_mul(A, B);
+    __m128 X_ = _mm_sub_ps(_mm_mul_ps(detD, A), mat2_mul(B, D_C));
+    __m128 W_ = _mm_sub_ps(_mm_mul_ps(detA, D), mat2_mul(C, A_B));
+    __m128 Y_ = _mm_sub_ps(_mm_mul_ps(detB, C), mat2_mul_adj(D, A_B));
+    __m128 Z_ = _mm_sub_ps(_mm_mul_ps(detC, B), mat2_mul_adj(A, D_C));
+
+    __m128 tr = _mm_mul_ps(A_B, LITEMATH_SWIZZLE(D_C, 0, 2, 1, 3));
+    tr = _mm_add_ps(tr, LITEMATH_SWIZZLE(tr, 1, 0, 3, 2));
+    tr = _mm_add_ps(tr, LITEMATH_SWIZZLE(tr, 2, 3, 0, 1));
+    const __m128 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+
+    const __m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+    X_ = _mm_mul_ps(X_, rDetM);
+    Y_ = _mm_mul_ps(Y_, rDetM);
+    Z_ = _mm_mul_ps(Z_, rDetM);
+    W_ = _mm_mul_ps(W_, rDetM);
+
+    float4x4 m;
+    _mm_store_ps(&m.row[0].x, LITEMATH_SHUFFLE(X_, Y_, 3, 1, 3, 1));
+    _mm_store_ps(&m.row[1].x, LITEMATH_SHUFFLE(X_, Y_, 2, 0, 2, 0));
+    _mm_store_ps(&m.row[2].x, LITEMATH_SHUFFLE(Z_, W_, 3, 1, 3, 1));
+    _mm_store_ps(&m.row[3].x, LITEMATH_SHUFFLE(Z_, W_, 2, 0, 2, 0));
+    return m;
+  }
+
+  #undef LITEMATH_SWIZZLE
+  #undef LITEMATH_SHUFFLE
+#endif
+
+  static inline constexpr float4x4 inverse4x4(const float4x4 & m1)
   {
-    float tmp[12]; // temp array for pairs
+    LITEMATH_SSE_RETURN(inverse4x4_sse(m1));
+    float tmp[12] = {}; // temp array for pairs
     float4x4 m;
 
     // calculate pairs for first 8 elements (cofactors)
@@ -608,8 +789,9 @@ namespace LiteMath
      return res;
    }
 
-   static inline float4x4 transpose(const float4x4 a_mat)
+   static inline constexpr float4x4 transpose(const float4x4 & a_mat)
    {
+     LITEMATH_SSE_RETURN(transpose4x4_sse(a_mat));
      float4x4 res;
      res.row[0].x = a_mat.row[0].x;
      res.row[0].y = a_mat.row[1].x;
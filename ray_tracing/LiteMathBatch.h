@@ -0,0 +1,249 @@
+#pragma once
+
+// structure-of-arrays batches for LiteMath: every component lives in its own
+// aligned array, padded to a multiple of 4, so one SSE register holds the same
+// component of 4 vectors and no lane is wasted on the padding of float3
+
+#include "LiteMath.h"
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace LiteMath
+{
+  template <class T, size_t Alignment = 16>
+  struct aligned_allocator
+  {
+    typedef T value_type;
+
+    template <class U> struct rebind { typedef aligned_allocator<U, Alignment> other; };
+
+    aligned_allocator() {}
+    template <class U> aligned_allocator(const aligned_allocator<U, Alignment>&) {}
+
+    T* allocate(size_t n)
+    {
+      if (n == 0)
+        return nullptr;
+#ifdef _WIN32
+      void* ptr = _aligned_malloc(n * sizeof(T), Alignment);
+#else
+      void* ptr = nullptr;
+      if (posix_memalign(&ptr, Alignment, n * sizeof(T)) != 0)
+        ptr = nullptr;
+#endif
+      if (ptr == nullptr)
+        throw std::bad_alloc();
+      return (T*)ptr;
+    }
+
+    void deallocate(T* ptr, size_t)
+    {
+#ifdef _WIN32
+      _aligned_free(ptr);
+#else
+      free(ptr);
+#endif
+    }
+  };
+
+  template <class T, class U, size_t A>
+  static inline bool operator == (const aligned_allocator<T, A>&, const aligned_allocator<U, A>&) { return true; }
+  template <class T, class U, size_t A>
+  static inline bool operator != (const aligned_allocator<T, A>&, const aligned_allocator<U, A>&) { return false; }
+
+  typedef std::vector<float, aligned_allocator<float> > aligned_float_vector;
+
+  static inline size_t batch_padded(size_t n) { return (n + 3) & ~size_t(3); }
+
+  struct floatN
+  {
+    void resize(size_t n) { count = n; v.resize(batch_padded(n), 0.0f); }
+    size_t size() const { return count; }
+
+    float& operator[](size_t i)       { return v[i]; }
+    float  operator[](size_t i) const { return v[i]; }
+
+    size_t count = 0;
+    aligned_float_vector v;
+  };
+
+  struct float3xN
+  {
+    void resize(size_t n)
+    {
+      count = n;
+      x.resize(batch_padded(n), 0.0f);
+      y.resize(batch_padded(n), 0.0f);
+      z.resize(batch_padded(n), 0.0f);
+    }
+    size_t size() const { return count; }
+
+    void   set(size_t i, const float3& a) { x[i] = a.x; y[i] = a.y; z[i] = a.z; }
+    float3 get(size_t i) const { return float3(x[i], y[i], z[i]); }
+
+    size_t count = 0;
+    aligned_float_vector x, y, z;
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // every function resizes its output, which may be one of the inputs;
+  // inputs of one call must have the same size
+
+#ifdef LITEMATH_SSE
+  #define LITEMATH_BATCH_LOOP(n) for (size_t i = 0; i < batch_padded(n); i += 4)
+#endif
+
+  static inline void dot(const float3xN& a, const float3xN& b, floatN& out)
+  {
+    out.resize(a.size());
+#ifdef LITEMATH_SSE
+    LITEMATH_BATCH_LOOP(a.size())
+    {
+      __m128 r = _mm_mul_ps(_mm_load_ps(&a.x[i]), _mm_load_ps(&b.x[i]));
+      r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(&a.y[i]), _mm_load_ps(&b.y[i])));
+      r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(&a.z[i]), _mm_load_ps(&b.z[i])));
+      _mm_store_ps(&out.v[i], r);
+    }
+#else
+    for (size_t i = 0; i < a.size(); i++)
+      out[i] = a.x[i]*b.x[i] + a.y[i]*b.y[i] + a.z[i]*b.z[i];
+#endif
+  }
+
+  static inline void length(const float3xN& a, floatN& out)
+  {
+    out.resize(a.size());
+#ifdef LITEMATH_SSE
+    LITEMATH_BATCH_LOOP(a.size())
+    {
+      const __m128 x = _mm_load_ps(&a.x[i]), y = _mm_load_ps(&a.y[i]), z = _mm_load_ps(&a.z[i]);
+      const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+      _mm_store_ps(&out.v[i], _mm_sqrt_ps(r));
+    }
+#else
+    for (size_t i = 0; i < a.size(); i++)
+      out[i] = sqrtf(a.x[i]*a.x[i] + a.y[i]*a.y[i] + a.z[i]*a.z[i]);
+#endif
+  }
+
+  static inline void normalize(const float3xN& a, float3xN& out)
+  {
+    out.resize(a.size());
+#ifdef LITEMATH_SSE
+    LITEMATH_BATCH_LOOP(a.size())
+    {
+      const __m128 x = _mm_load_ps(&a.x[i]), y = _mm_load_ps(&a.y[i]), z = _mm_load_ps(&a.z[i]);
+      const __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+      _mm_store_ps(&out.x[i], _mm_div_ps(x, len));
+      _mm_store_ps(&out.y[i], _mm_div_ps(y, len));
+      _mm_store_ps(&out.z[i], _mm_div_ps(z, len));
+    }
+#else
+    for (size_t i = 0; i < a.size(); i++)
+    {
+      const float len = sqrtf(a.x[i]*a.x[i] + a.y[i]*a.y[i] + a.z[i]*a.z[i]);
+      out.x[i] = a.x[i] / len;
+      out.y[i] = a.y[i] / len;
+      out.z[i] = a.z[i] / len;
+    }
+#endif
+  }
+
+#ifdef LITEMATH_SSE
+  #define LITEMATH_BATCH_BINARY(name, simd_op, scalar_op)                                 \
+  static inline void name(const float3xN& a, const float3xN& b, float3xN& out)            \
+  {                                                                                       \
+    out.resize(a.size());                                                                 \
+    LITEMATH_BATCH_LOOP(a.size())                                                         \
+    {                                                                                     \
+      _mm_store_ps(&out.x[i], simd_op(_mm_load_ps(&a.x[i]), _mm_load_ps(&b.x[i])));       \
+      _mm_store_ps(&out.y[i], simd_op(_mm_load_ps(&a.y[i]), _mm_load_ps(&b.y[i])));       \
+      _mm_store_ps(&out.z[i], simd_op(_mm_load_ps(&a.z[i]), _mm_load_ps(&b.z[i])));       \
+    }                                                                                     \
+  }
+#else
+  #define LITEMATH_BATCH_BINARY(name, simd_op, scalar_op)                                 \
+  static inline void name(const float3xN& a, const float3xN& b, float3xN& out)            \
+  {                                                                                       \
+    out.resize(a.size());                                                                 \
+    for (size_t i = 0; i < a.size(); i++)                                                 \
+    {                                                                                     \
+      out.x[i] = scalar_op(a.x[i], b.x[i]);                                               \
+      out.y[i] = scalar_op(a.y[i], b.y[i]);                                               \
+      out.z[i] = scalar_op(a.z[i], b.z[i]);                                               \
+    }                                                                                     \
+  }
+#endif
+
+  LITEMATH_BATCH_BINARY(min, _mm_min_ps, fminf)
+  LITEMATH_BATCH_BINARY(max, _mm_max_ps, fmaxf)
+
+  #undef LITEMATH_BATCH_BINARY
+
+  static inline void clamp(const float3xN& a, const float3& lo, const float3& hi, float3xN& out)
+  {
+    out.resize(a.size());
+#ifdef LITEMATH_SSE
+    const __m128 loX = _mm_set1_ps(lo.x), loY = _mm_set1_ps(lo.y), loZ = _mm_set1_ps(lo.z);
+    const __m128 hiX = _mm_set1_ps(hi.x), hiY = _mm_set1_ps(hi.y), hiZ = _mm_set1_ps(hi.z);
+    LITEMATH_BATCH_LOOP(a.size())
+    {
+      _mm_store_ps(&out.x[i], _mm_min_ps(_mm_max_ps(_mm_load_ps(&a.x[i]), loX), hiX));
+      _mm_store_ps(&out.y[i], _mm_min_ps(_mm_max_ps(_mm_load_ps(&a.y[i]), loY), hiY));
+      _mm_store_ps(&out.z[i], _mm_min_ps(_mm_max_ps(_mm_load_ps(&a.z[i]), loZ), hiZ));
+    }
+#else
+    for (size_t i = 0; i < a.size(); i++)
+    {
+      out.x[i] = fminf(fmaxf(a.x[i], lo.x), hi.x);
+      out.y[i] = fminf(fmaxf(a.y[i], lo.y), hi.y);
+      out.z[i] = fminf(fmaxf(a.z[i], lo.z), hi.z);
+    }
+#endif
+  }
+
+  // out = m * (p, w) for every p, w = 1 transforms points and w = 0 directions
+  static inline void mul(const float4x4& m, const float3xN& a, float w, float3xN& out)
+  {
+    out.resize(a.size());
+#ifdef LITEMATH_SSE
+    __m128 r[3][4];
+    for (int j = 0; j < 3; j++)
+    {
+      r[j][0] = _mm_set1_ps(m.row[j].x);
+      r[j][1] = _mm_set1_ps(m.row[j].y);
+      r[j][2] = _mm_set1_ps(m.row[j].z);
+      r[j][3] = _mm_set1_ps(m.row[j].w * w);
+    }
+    LITEMATH_BATCH_LOOP(a.size())
+    {
+      const __m128 x = _mm_load_ps(&a.x[i]), y = _mm_load_ps(&a.y[i]), z = _mm_load_ps(&a.z[i]);
+      float* dst[3] = { &out.x[i], &out.y[i], &out.z[i] };
+      for (int j = 0; j < 3; j++)
+      {
+        const __m128 res = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[j][0], x), _mm_mul_ps(r[j][1], y)),
+                                      _mm_add_ps(_mm_mul_ps(r[j][2], z), r[j][3]));
+        _mm_store_ps(dst[j], res);
+      }
+    }
+#else
+    for (size_t i = 0; i < a.size(); i++)
+    {
+      const float x = a.x[i], y = a.y[i], z = a.z[i];
+      out.x[i] = m.row[0].x*x + m.row[0].y*y + m.row[0].z*z + m.row[0].w*w;
+      out.y[i] = m.row[1].x*x + m.row[1].y*y + m.row[1].z*z + m.row[1].w*w;
+      out.z[i] = m.row[2].x*x + m.row[2].y*y + m.row[2].z*z + m.row[2].w*w;
+    }
+#endif
+  }
+
+#ifdef LITEMATH_SSE
+  #undef LITEMATH_BATCH_LOOP
+#endif
+};
@@ -0,0 +1,137 @@
+#include "MarchStats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+const char *const MarchStats::NAMES[MarchStats::COUNTERS] = {"march steps", "shadow steps", "bounces", "sdf calls"};
+
+bool MarchStats::Init(int newWidth, int newHeight)
+{
+    Release();
+    width = newWidth;
+    height = newHeight;
+    glGenTextures(1, &color);
+    glBindTexture(GL_TEXTURE_2D, color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glGenTextures(1, &counters);
+    glBindTexture(GL_TEXTURE_2D, counters);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, width, height, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, counters, 0);
+    GLenum buffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, buffers);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+    if (!complete) {
+        std::cout << "Failed to create the ray marching counters target" << std::endl;
+        Release();
+    }
+    return complete;
+}
+
+void MarchStats::Release()
+{
+    if (fbo) {
+        glDeleteFramebuffers(1, &fbo);
+        fbo = 0;
+    }
+    if (color) {
+        glDeleteTextures(1, &color);
+        color = 0;
+    }
+    if (counters) {
+        glDeleteTextures(1, &counters);
+        counters = 0;
+    }
+}
+
+void MarchStats::Reduce()
+{
+    if (!fbo) {
+        return;
+    }
+    data.resize((size_t)width * height * COUNTERS);
+    GLint previous = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glReadBuffer(GL_COLOR_ATTACHMENT1);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA_INTEGER, GL_UNSIGNED_INT, data.data());
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previous);
+    for (size_t i = 0; i < data.size(); i += COUNTERS) {
+        for (int c = 0; c < COUNTERS; ++c) {
+            uint32_t value = data[i + c];
+            totals[c] += value;
+            maxima[c] = std::max(maxima[c], value);
+            int bucket = 0;
+            while (value && bucket < BUCKETS - 1) {
+                value >>= 1;
+                ++bucket;
+            }
+            ++histograms[c][bucket];
+        }
+    }
+    pixels += (uint64_t)width * height;
+    ++frames;
+}
+
+void MarchStats::Reset()
+{
+    frames = 0;
+    pixels = 0;
+    for (int c = 0; c < COUNTERS; ++c) {
+        totals[c] = 0;
+        maxima[c] = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            histograms[c][b] = 0;
+        }
+    }
+}
+
+void MarchStats::PrintSummary() const
+{
+    if (frames == 0) {
+        return;
+    }
+    printf("%-14s %12s %10s %8s   histogram, %% of pixels with 0, 1, 2-3, 4-7, ...\n", "march stats", "per frame", "per pixel", "max");
+    for (int c = 0; c < COUNTERS; ++c) {
+        printf("%-14s %12.0f %10.2f %8u  ", NAMES[c], (double)totals[c] / frames, (double)totals[c] / pixels, maxima[c]);
+        int last = BUCKETS - 1;
+        while (last > 0 && histograms[c][last] == 0) {
+            --last;
+        }
+        for (int b = 0; b <= last; ++b) {
+            printf(" %.1f", 100.0 * histograms[c][b] / pixels);
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+}
+
+std::string MarchStats::Json() const
+{
+    std::string json = "\"march_stats\": {\"frames\": " + std::to_string(frames) + ", \"pixels\": " + std::to_string(pixels) + ", \"counters\": [\n";
+    for (int c = 0; c < COUNTERS; ++c) {
+        char line[128];
+        snprintf(line, sizeof(line), "{\"counter\": \"%s\", \"per_frame\": %.1f, \"per_pixel\": %.4f, \"max\": %u, \"histogram\": [",
+                 NAMES[c], frames ? (double)totals[c] / frames : 0.0, pixels ? (double)totals[c] / pixels : 0.0, maxima[c]);
+        json += line;
+        for (int b = 0; b < BUCKETS; ++b) {
+            json += (b ? ", " : "") + std::to_string(histograms[c][b]);
+        }
+        json += c + 1 < COUNTERS ? "]},\n" : "]}\n";
+    }
+    return json + "]}";
+}
@@ -0,0 +1,64 @@
+#ifndef MARCHSTATS_H
+#define MARCHSTATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+//Cost of the ray marcher per pixel, for the fragment shader built with MARCH_STATS:
+//march steps, shadow steps, reflection bounces and sceneSDF calls are written to an
+//RGBA32UI attachment next to the colour one. GL 3.3 has no storage buffers, so the
+//counters are a render target; Reduce() reads them back synchronously.
+class MarchStats
+{
+public:
+    static const int COUNTERS = 4;
+    static const int BUCKETS = 16; //bucket 0 counts zeros, bucket b counts from 2^(b-1) to 2^b - 1
+
+    static const char *const NAMES[COUNTERS];
+
+    //(re)creates the targets for a new size, the totals are kept
+    bool Init(int width, int height);
+
+    void Release(); //actual destructor
+
+    GLuint Framebuffer() const { return fbo; }
+
+    GLuint ColorTexture() const { return color; }
+
+    GLuint CounterTexture() const { return counters; }
+
+    int Width() const { return width; }
+
+    int Height() const { return height; }
+
+    //adds the counters of the frame in the framebuffer to the totals and histograms
+    void Reduce();
+
+    void Reset();
+
+    int Frames() const { return frames; }
+
+    //per frame and per pixel means, maxima and histograms
+    void PrintSummary() const;
+
+    //"march_stats" member of the benchmark report
+    std::string Json() const;
+
+private:
+    GLuint fbo = 0;
+    GLuint color = 0;
+    GLuint counters = 0;
+    int width = 0;
+    int height = 0;
+    int frames = 0;
+    uint64_t pixels = 0;
+    uint64_t totals[COUNTERS] = {};
+    uint32_t maxima[COUNTERS] = {};
+    uint64_t histograms[COUNTERS][BUCKETS] = {};
+    std::vector<GLuint> data;
+};
+
+#endif
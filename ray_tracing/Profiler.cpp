@@ -0,0 +1,160 @@
+#include "Profiler.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstdio>
+
+void FrameProfiler::Samples::Add(float value, size_t window)
+{
+    if (values.size() < window) {
+        values.push_back(value);
+    } else {
+        values[next % values.size()] = value;
+    }
+    next = (next + 1) % window;
+}
+
+float FrameProfiler::Samples::Percentile(float p) const
+{
+    if (values.empty()) {
+        return 0.0f;
+    }
+    std::vector<float> sorted = values;
+    size_t rank = std::min((size_t)(p / 100.0f * sorted.size()), sorted.size() - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+int FrameProfiler::AddPass(const std::string &name, bool gpu)
+{
+    Pass pass;
+    pass.name = name;
+    pass.gpu = gpu;
+    passes.push_back(pass);
+    return (int)passes.size() - 1;
+}
+
+void FrameProfiler::SetEnabled(bool newEnabled)
+{
+    enabled = newEnabled;
+    for (Pass &pass : passes) {
+        //queries are made on first use, there is a context by then
+        if (enabled && pass.gpu && !pass.queries[0]) {
+            glGenQueries(2, pass.queries);
+        }
+        pass.issued[0] = pass.issued[1] = false;
+        pass.gpuMs.values.clear();
+        pass.cpuMs.values.clear();
+        pass.gpuMs.next = pass.cpuMs.next = 0;
+    }
+    frames = 0;
+}
+
+void FrameProfiler::Begin(int index)
+{
+    if (!enabled) {
+        return;
+    }
+    Pass &pass = passes[index];
+    pass.running = true;
+    if (pass.gpu) {
+        glBeginQuery(GL_TIME_ELAPSED, pass.queries[parity]);
+    }
+    pass.cpuStart = std::chrono::steady_clock::now();
+    pass.traceStart = Trace::Enabled() ? Trace::Now() : 0;
+}
+
+void FrameProfiler::End(int index)
+{
+    if (!enabled || !passes[index].running) {
+        return;
+    }
+    Pass &pass = passes[index];
+    pass.cpuMs.Add(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - pass.cpuStart).count(), window);
+    if (pass.traceStart && Trace::Enabled()) {
+        Trace::Record(pass.name.c_str(), pass.traceStart, Trace::Now());
+    }
+    if (pass.gpu) {
+        glEndQuery(GL_TIME_ELAPSED);
+        pass.issued[parity] = true;
+        pass.issueTime[parity] = pass.cpuStart;
+        pass.traceIssue[parity] = pass.traceStart;
+    }
+    pass.running = false;
+}
+
+void FrameProfiler::EndFrame()
+{
+    if (!enabled) {
+        return;
+    }
+    parity ^= 1;
+    for (Pass &pass : passes) {
+        if (pass.issued[parity]) {
+            pass.issued[parity] = false;
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(pass.queries[parity], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                continue;
+            }
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(pass.queries[parity], GL_QUERY_RESULT, &nanoseconds);
+            //a pass cannot take longer than the time since it was issued; llvmpipe's
+            //first query of a context reports the clock value instead of a duration
+            float wallMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - pass.issueTime[parity]).count();
+            if (nanoseconds / 1e6f <= wallMs) {
+                pass.gpuMs.Add(nanoseconds / 1e6f, window);
+                if (pass.traceIssue[parity] && Trace::Enabled()) {
+                    Trace::RecordGpu(pass.name.c_str(), pass.traceIssue[parity], nanoseconds);
+                }
+            }
+        }
+    }
+    if (reportInterval > 0 && ++frames % reportInterval == 0) {
+        PrintSummary();
+    }
+}
+
+void FrameProfiler::PrintSummary() const
+{
+    printf("%-14s %26s %27s\n", "ms", "gpu p50 / p95 / p99", "cpu p50 / p95 / p99");
+    for (const Pass &pass : passes) {
+        if (pass.cpuMs.values.empty()) {
+            continue;
+        }
+        char gpu[32] = "-";
+        if (!pass.gpuMs.values.empty()) {
+            snprintf(gpu, sizeof(gpu), "%7.3f %7.3f %7.3f", pass.gpuMs.Percentile(50), pass.gpuMs.Percentile(95), pass.gpuMs.Percentile(99));
+        }
+        printf("%-14s %26s %8.3f %8.3f %8.3f\n", pass.name.c_str(), gpu,
+               pass.cpuMs.Percentile(50), pass.cpuMs.Percentile(95), pass.cpuMs.Percentile(99));
+    }
+    fflush(stdout);
+}
+
+bool FrameProfiler::Stats(int index, bool gpu, TimingStats &stats) const
+{
+    const Samples &samples = gpu ? passes[index].gpuMs : passes[index].cpuMs;
+    if (samples.values.empty()) {
+        return false;
+    }
+    double sum = 0.0;
+    for (float value : samples.values) {
+        sum += value;
+    }
+    stats.mean = (float)(sum / samples.values.size());
+    stats.p50 = samples.Percentile(50);
+    stats.p95 = samples.Percentile(95);
+    stats.p99 = samples.Percentile(99);
+    return true;
+}
+
+void FrameProfiler::Release()
+{
+    for (Pass &pass : passes) {
+        if (pass.queries[0]) {
+            glDeleteQueries(2, pass.queries);
+            pass.queries[0] = pass.queries[1] = 0;
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+//Per-pass GPU (GL_TIME_ELAPSED) and CPU timings with a rolling percentile summary.
+//Every pass owns two query objects used on alternate frames, a result is read one
+//frame after it was issued; when the GPU has not finished it yet the sample is dropped
+//instead of waiting for it.
+//While disabled Begin()/End() only test a flag. While a trace is recorded the
+//passes also go to it, GPU results on the GPU track.
+struct TimingStats
+{
+    float mean;
+    float p50;
+    float p95;
+    float p99;
+};
+
+class FrameProfiler
+{
+public:
+    //call before the first frame; gpu = false for CPU-only timers
+    int AddPass(const std::string &name, bool gpu = true);
+
+    void SetEnabled(bool enabled);
+
+    bool Enabled() const { return enabled; }
+
+    void Begin(int pass);
+
+    void End(int pass);
+
+    //collects the previous frame's GPU results, prints the summary every reportInterval frames
+    void EndFrame();
+
+    void PrintSummary() const;
+
+    int PassCount() const { return (int)passes.size(); }
+
+    const std::string &PassName(int pass) const { return passes[pass].name; }
+
+    //false when the pass has no samples of that kind
+    bool Stats(int pass, bool gpu, TimingStats &stats) const;
+
+    void Release(); //actual destructor
+
+    int reportInterval = 120;
+
+    size_t window = 240; //samples kept per pass
+
+private:
+    struct Samples
+    {
+        std::vector<float> values;
+        size_t next = 0;
+
+        void Add(float value, size_t window);
+        float Percentile(float p) const;
+    };
+
+    struct Pass
+    {
+        std::string name;
+        bool gpu;
+        GLuint queries[2] = {0, 0};
+        bool issued[2] = {false, false};
+        bool running = false;
+        std::chrono::steady_clock::time_point cpuStart;
+        std::chrono::steady_clock::time_point issueTime[2];
+        uint64_t traceStart = 0;
+        uint64_t traceIssue[2] = {0, 0};
+        Samples gpuMs;
+        Samples cpuMs;
+    };
+
+    std::vector<Pass> passes;
+    bool enabled = false;
+    int parity = 0;
+    int frames = 0;
+};
+
+//CPU (and GPU when the pass has queries) time of a scope
+class ProfileScope
+{
+public:
+    ProfileScope(FrameProfiler &profiler, int pass) : profiler(profiler), pass(pass) { profiler.Begin(pass); }
+
+    ~ProfileScope() { profiler.End(pass); }
+
+private:
+    FrameProfiler &profiler;
+    int pass;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "Progressive.h"
+
+#include <iostream>
+
+static float Halton(int index, int base)
+{
+    float result = 0.0f;
+    float fraction = 1.0f / base;
+    for (; index > 0; index /= base) {
+        result += fraction * (index % base);
+        fraction /= base;
+    }
+    return result;
+}
+
+bool Progressive::Init(int newWidth, int newHeight)
+{
+    Release();
+    width = newWidth;
+    height = newHeight;
+    glGenTextures(1, &color);
+    glBindTexture(GL_TEXTURE_2D, color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+    if (!complete) {
+        std::cout << "Failed to create the accumulation target" << std::endl;
+        Release();
+        return false;
+    }
+    Reset();
+    return true;
+}
+
+void Progressive::Release()
+{
+    if (fbo) {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(1, &color);
+        fbo = color = 0;
+    }
+}
+
+void Progressive::Reset()
+{
+    samples = 0;
+}
+
+void Progressive::NextJitter(float &x, float &y) const
+{
+    x = samples ? Halton(samples, 2) - 0.5f : 0.0f;
+    y = samples ? Halton(samples, 3) - 0.5f : 0.0f;
+}
+
+void Progressive::BeginSample()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    if (samples == 0) {
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        start = std::chrono::steady_clock::now();
+    }
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+}
+
+void Progressive::EndSample()
+{
+    glDisable(GL_BLEND);
+    ++samples;
+    //the time to converge counts until the GPU has drawn the last sample,
+    //samples before it are timed when they are submitted
+    if (Converged()) {
+        glFinish();
+    }
+    last = std::chrono::steady_clock::now();
+}
+
+float Progressive::Seconds() const
+{
+    return samples ? std::chrono::duration<float>(last - start).count() : 0.0f;
+}
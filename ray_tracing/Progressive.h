@@ -0,0 +1,56 @@
+#ifndef PROGRESSIVE_H
+#define PROGRESSIVE_H
+
+#include <chrono>
+
+#include "common.h"
+
+//Progressive rendering of a still view: every frame adds one more ray per pixel, jittered
+//inside the pixel by the Halton (2, 3) sequence, to an RGBA32F target with additive
+//blending; the display pass divides by the sample count. Stops tracing at maxSamples.
+class Progressive
+{
+public:
+    bool Init(int width, int height);
+
+    void Release(); //actual destructor
+
+    int Width() const { return width; }
+
+    int Height() const { return height; }
+
+    GLuint Framebuffer() const { return fbo; }
+
+    GLuint Accumulated() const { return color; }
+
+    //starts over, the view has changed
+    void Reset();
+
+    bool Converged() const { return samples >= maxSamples; }
+
+    int Samples() const { return samples; }
+
+    //sub-pixel offset in [-0.5, 0.5) of the next sample, the first one goes through the centre
+    void NextJitter(float &x, float &y) const;
+
+    //binds the target with additive blending
+    void BeginSample();
+
+    void EndSample();
+
+    //seconds from the first sample until the last one is submitted, or drawn once converged
+    float Seconds() const;
+
+    int maxSamples = 256;
+
+private:
+    GLuint fbo = 0;
+    GLuint color = 0;
+    int width = 0;
+    int height = 0;
+    int samples = 0;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point last;
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef REDRAW_GATE_H
+#define REDRAW_GATE_H
+
+#include <vector>
+
+//Decides whether a window frame is worth drawing. A frame is drawn when the state the
+//image depends on has changed or more frames were requested (a pass that converges over
+//several frames, an exposed window); otherwise Wait() sleeps in glfwWaitEvents until
+//input arrives. With idleFps > 0 an unchanged frame is still drawn that often.
+class RedrawGate
+{
+public:
+    //compares the state with the one of the last call, a change requests a frame
+    bool Changed(const float *state, int count);
+
+    //at least this many more frames
+    void Request(int frames = 1);
+
+    //true when a frame should be drawn now, counts it
+    bool NextFrame();
+
+    //blocks until an event or the next idle frame
+    void Wait() const;
+
+    double idleFps = 0.0;
+
+private:
+    std::vector<float> last;
+    int requested = 0;
+    double lastFrame = 0.0;
+};
+
+#endif
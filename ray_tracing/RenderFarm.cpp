@@ -0,0 +1,239 @@
+#include "RenderFarm.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <thread>
+
+#include "FrameSequence.h"
+#include "Headless.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+bool ParseTile(const char *text, Tile &tile)
+{
+    return sscanf(text, "%d,%d,%d,%d", &tile.x, &tile.y, &tile.width, &tile.height) == 4 && !tile.Empty();
+}
+
+static bool ReadPPM(const std::string &path, int &width, int &height, std::vector<unsigned char> &rgb)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    int maxValue = 0;
+    bool read = fscanf(file, "P6 %d %d %d", &width, &height, &maxValue) == 3 && maxValue == 255 && fgetc(file) != EOF;
+    if (read) {
+        rgb.resize((size_t)width * height * 3);
+        read = fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+    }
+    fclose(file);
+    return read;
+}
+
+static std::vector<Tile> SplitTiles(int width, int height, int tilesX, int tilesY)
+{
+    std::vector<Tile> tiles;
+    for (int ty = 0; ty < tilesY; ++ty) {
+        for (int tx = 0; tx < tilesX; ++tx) {
+            Tile tile;
+            tile.x = tx * width / tilesX;
+            tile.y = ty * height / tilesY;
+            tile.width = (tx + 1) * width / tilesX - tile.x;
+            tile.height = (ty + 1) * height / tilesY - tile.y;
+            tiles.push_back(tile);
+        }
+    }
+    return tiles;
+}
+
+#ifndef _WIN32
+struct FarmJob
+{
+    int firstFrame;
+    int frameCount;
+    int tile; //-1 for whole frames
+    int attempts;
+};
+
+struct RunningJob
+{
+    FarmJob job;
+    pid_t pid;
+    std::chrono::steady_clock::time_point started;
+};
+
+static std::string JobOutput(const std::string &outputDir, const FarmJob &job)
+{
+    return job.tile < 0 ? outputDir : outputDir + "/tiles/" + std::to_string(job.tile);
+}
+
+static std::string JobName(const FarmJob &job)
+{
+    std::string name = "frames " + std::to_string(job.firstFrame) + "-" + std::to_string(job.firstFrame + job.frameCount - 1);
+    return job.tile < 0 ? name : name + " of tile " + std::to_string(job.tile);
+}
+
+static std::string SelfPath(const std::string &argv0)
+{
+    char path[4096];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length <= 0) {
+        return argv0;
+    }
+    path[length] = '\0';
+    return path;
+}
+
+static pid_t SpawnWorker(const std::string &exe, const std::vector<std::string> &args, const FarmJob &job, const std::vector<Tile> &tiles, const std::string &outputDir)
+{
+    std::vector<std::string> workerArgs = args;
+    workerArgs[0] = exe;
+    workerArgs.push_back("--headless");
+    workerArgs.push_back("--frame-range");
+    workerArgs.push_back(std::to_string(job.firstFrame) + ":" + std::to_string(job.frameCount));
+    workerArgs.push_back("--output");
+    workerArgs.push_back(JobOutput(outputDir, job));
+    if (job.tile >= 0) {
+        const Tile &tile = tiles[job.tile];
+        workerArgs.push_back("--tile");
+        workerArgs.push_back(std::to_string(tile.x) + "," + std::to_string(tile.y) + "," + std::to_string(tile.width) + "," + std::to_string(tile.height));
+    }
+    std::vector<char *> argv;
+    for (std::string &arg : workerArgs) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+    pid_t pid;
+    if (posix_spawn(&pid, exe.c_str(), nullptr, nullptr, argv.data(), environ) != 0) {
+        return -1;
+    }
+    return pid;
+}
+
+static bool JobOutputsExist(const std::string &outputDir, const FarmJob &job)
+{
+    for (int frame = job.firstFrame; frame < job.firstFrame + job.frameCount; ++frame) {
+        FILE *file = fopen(FramePath(JobOutput(outputDir, job), frame).c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+        fclose(file);
+    }
+    return true;
+}
+
+static bool StitchTiles(const std::vector<Tile> &tiles, int frameCount, int width, int height, const std::string &outputDir)
+{
+    std::vector<unsigned char> image((size_t)width * height * 3);
+    std::vector<unsigned char> part;
+    for (int frame = 0; frame < frameCount; ++frame) {
+        for (size_t t = 0; t < tiles.size(); ++t) {
+            const Tile &tile = tiles[t];
+            std::string path = FramePath(outputDir + "/tiles/" + std::to_string(t), frame);
+            int partWidth, partHeight;
+            if (!ReadPPM(path, partWidth, partHeight, part) || partWidth != tile.width || partHeight != tile.height) {
+                std::cout << "Tile " << path << " is missing or has the wrong size" << std::endl;
+                return false;
+            }
+            for (int y = 0; y < tile.height; ++y) {
+                std::copy(&part[(size_t)y * tile.width * 3], &part[(size_t)(y + 1) * tile.width * 3],
+                          &image[((size_t)(tile.y + y) * width + tile.x) * 3]);
+            }
+            remove(path.c_str());
+        }
+        if (!WritePPM(FramePath(outputDir, frame), width, height, image.data())) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+bool RunCoordinator(const std::vector<std::string> &args, const FarmSettings &settings, int frameCount, int width, int height, const std::string &outputDir)
+{
+#ifdef _WIN32
+    std::cout << "Coordinator mode needs POSIX processes" << std::endl;
+    return false;
+#else
+    std::vector<Tile> tiles = SplitTiles(width, height, std::max(settings.tilesX, 1), std::max(settings.tilesY, 1));
+    bool tiled = tiles.size() > 1;
+    int chunk = settings.chunk;
+    if (chunk <= 0) {
+        chunk = (int)((frameCount * tiles.size() + settings.workers - 1) / settings.workers);
+    }
+    chunk = std::max(std::min(chunk, frameCount), 1);
+    std::deque<FarmJob> pending;
+    for (size_t t = 0; t < tiles.size(); ++t) {
+        for (int first = 0; first < frameCount; first += chunk) {
+            pending.push_back(FarmJob{first, std::min(chunk, frameCount - first), tiled ? (int)t : -1, 0});
+        }
+    }
+    size_t jobCount = pending.size();
+    std::cout << "Rendering " << frameCount << " frames as " << jobCount << " jobs on " << settings.workers << " workers" << std::endl;
+
+    std::string exe = SelfPath(args[0]);
+    std::vector<RunningJob> running;
+    size_t finished = 0;
+    bool failed = false;
+    while (!failed && (!pending.empty() || !running.empty())) {
+        while (!failed && !pending.empty() && (int)running.size() < settings.workers) {
+            FarmJob job = pending.front();
+            pending.pop_front();
+            pid_t pid = SpawnWorker(exe, args, job, tiles, outputDir);
+            if (pid < 0) {
+                std::cout << "Failed to start a worker for " << JobName(job) << std::endl;
+                failed = true;
+            } else {
+                running.push_back(RunningJob{job, pid, std::chrono::steady_clock::now()});
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        for (size_t i = 0; i < running.size();) {
+            int status = 0;
+            pid_t done = waitpid(running[i].pid, &status, WNOHANG);
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - running[i].started).count();
+            bool timedOut = done == 0 && settings.timeout > 0 && elapsed > settings.timeout;
+            if (done == 0 && !timedOut) {
+                ++i;
+                continue;
+            }
+            if (timedOut) {
+                kill(running[i].pid, SIGKILL);
+                waitpid(running[i].pid, &status, 0);
+            }
+            FarmJob job = running[i].job;
+            running.erase(running.begin() + i);
+            if (!timedOut && WIFEXITED(status) && WEXITSTATUS(status) == 0 && JobOutputsExist(outputDir, job)) {
+                ++finished;
+                std::cout << "Done " << JobName(job) << " (" << finished << "/" << jobCount << ")" << std::endl;
+                continue;
+            }
+            std::cout << (timedOut ? "Timed out " : "Failed ") << JobName(job) << std::endl;
+            if (++job.attempts > settings.retries) {
+                failed = true;
+            } else {
+                pending.push_back(job);
+            }
+        }
+    }
+    if (failed) {
+        for (RunningJob &job : running) {
+            kill(job.pid, SIGKILL);
+            waitpid(job.pid, nullptr, 0);
+        }
+        std::cout << "Render failed" << std::endl;
+        return false;
+    }
+    return !tiled || StitchTiles(tiles, frameCount, width, height, outputDir);
+#endif
+}
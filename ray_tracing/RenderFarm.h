@@ -0,0 +1,39 @@
+#ifndef RENDERFARM_H
+#define RENDERFARM_H
+
+#include <string>
+#include <vector>
+
+//part of a frame in pixels, y goes down from the top row like in the written images
+struct Tile
+{
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    bool Empty() const { return width <= 0 || height <= 0; }
+};
+
+//"x,y,width,height"
+bool ParseTile(const char *text, Tile &tile);
+
+struct FarmSettings
+{
+    int workers = 0;     //worker processes running at once, 0 disables the coordinator
+    int tilesX = 1;      //every frame is split into tilesX x tilesY tiles
+    int tilesY = 1;
+    int chunk = 0;       //frames per job, 0 spreads the sequence over the workers
+    double timeout = 0;  //seconds a job may run before it is killed and retried, 0 is no limit
+    int retries = 2;     //extra attempts of a failed job before the whole render fails
+};
+
+//Renders frameCount frames of width x height with worker processes of this
+//executable. The sequence is cut into jobs (a chunk of frames of one tile),
+//each job runs "args --headless --frame-range first:count --output dir [--tile x,y,w,h]".
+//Jobs that exit with an error, miss frames or run past the timeout are retried.
+//Tiles go to outputDir/tiles/<n> and are stitched into outputDir/frame_NNNN.ppm,
+//so outputDir may be on a filesystem shared with other hosts.
+bool RunCoordinator(const std::vector<std::string> &args, const FarmSettings &settings, int frameCount, int width, int height, const std::string &outputDir);
+
+#endif
@@ -0,0 +1,109 @@
+#include "ReprojectionCache.h"
+
+#include <iostream>
+
+static GLuint CreateTexture(GLenum internalFormat, GLenum format, GLenum type, GLenum filter, int width, int height)
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+bool ReprojectionCache::Init(int newWidth, int newHeight)
+{
+    Release();
+    width = newWidth;
+    height = newHeight;
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    bool complete = true;
+    for (int i = 0; i < 3; ++i) {
+        //colour is filtered when it is moved, the hits are fetched as they are
+        //the checkerboard trace is half as wide
+        int targetWidth = i < 2 ? width : (width + 1) / 2;
+        color[i] = CreateTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_LINEAR, targetWidth, height);
+        aux[i] = CreateTexture(GL_RGBA32F, GL_RGBA, GL_FLOAT, GL_NEAREST, targetWidth, height);
+        glGenFramebuffers(1, &fbo[i]);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color[i], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, aux[i], 0);
+        GLenum buffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glDrawBuffers(2, buffers);
+        complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+    tiles = CreateTexture(GL_R8, GL_RED, GL_UNSIGNED_BYTE, GL_NEAREST, TilesWidth(), TilesHeight());
+    glGenFramebuffers(1, &tileFbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, tileFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tiles, 0);
+    complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+    if (!complete) {
+        std::cout << "Failed to create the reprojection history" << std::endl;
+        Release();
+    }
+    return complete;
+}
+
+void ReprojectionCache::Release()
+{
+    for (int i = 0; i < 3; ++i) {
+        if (fbo[i]) {
+            glDeleteFramebuffers(1, &fbo[i]);
+            glDeleteTextures(1, &color[i]);
+            glDeleteTextures(1, &aux[i]);
+            fbo[i] = color[i] = aux[i] = 0;
+        }
+    }
+    if (tileFbo) {
+        glDeleteFramebuffers(1, &tileFbo);
+        glDeleteTextures(1, &tiles);
+        tileFbo = tiles = 0;
+    }
+    valid = false;
+}
+
+void ReprojectionCache::Swap()
+{
+    current ^= 1;
+    valid = true;
+}
+
+void ReprojectionCache::Blit(GLuint target, int targetWidth, int targetHeight) const
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo[current]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, targetWidth, targetHeight, GL_COLOR_BUFFER_BIT,
+                      width == targetWidth && height == targetHeight ? GL_NEAREST : GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+}
+
+void ReprojectionCache::Sample()
+{
+    data.resize((size_t)width * height * 4);
+    GLint previous = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo[current]);
+    glReadBuffer(GL_COLOR_ATTACHMENT1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_FLOAT, data.data());
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previous);
+    for (size_t i = 2; i < data.size(); i += 4) {
+        reused += data[i] > 0.5f;
+    }
+    pixels += (uint64_t)width * height;
+    ++samples;
+}
+
+void ReprojectionCache::ResetSamples()
+{
+    samples = 0;
+    reused = 0;
+    pixels = 0;
+}
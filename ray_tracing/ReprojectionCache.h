@@ -0,0 +1,93 @@
+#ifndef REPROJECTIONCACHE_H
+#define REPROJECTIONCACHE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "common.h"
+
+//History of the ray tracer for the fragment shader built with REPROJECTION: two
+//framebuffers used in turn, each with the colour and an RGBA32F attachment holding the
+//primary hit distance, its primitive and whether the pixel was reused. A frame is drawn
+//into one while the shader reads the other; pixels of static, non-reflective surfaces
+//are moved there from the last frame instead of being marched again. Whether they may
+//be is decided for blocks of TILE x TILE pixels by a pass into a small R8 target, so that
+//the traced pixels come in whole blocks.
+//In checkerboard mode the shader traces half of the pixels into a third, half as wide
+//pair of attachments and a resolve pass fills the others into the current framebuffer.
+class ReprojectionCache
+{
+public:
+    //drops the history
+    bool Init(int width, int height);
+
+    void Release(); //actual destructor
+
+    int Width() const { return width; }
+
+    int Height() const { return height; }
+
+    //the frame being drawn
+    GLuint Framebuffer() const { return fbo[current]; }
+
+    //last frame's attachments
+    GLuint HistoryColor() const { return color[current ^ 1]; }
+
+    GLuint HistoryAux() const { return aux[current ^ 1]; }
+
+    //target of the checkerboard trace
+    GLuint RawFramebuffer() const { return fbo[2]; }
+
+    GLuint RawColor() const { return color[2]; }
+
+    GLuint RawAux() const { return aux[2]; }
+
+    //one texel per block, 1 - moved from the last frame
+    GLuint TileFramebuffer() const { return tileFbo; }
+
+    GLuint Tiles() const { return tiles; }
+
+    int TilesWidth() const { return (width + TILE - 1) / TILE; }
+
+    int TilesHeight() const { return (height + TILE - 1) / TILE; }
+
+    static const int TILE = 8; //same as in fragment_TILES.glsl and fragment.glsl
+
+    //false until a frame has been drawn with the current size and settings
+    bool Valid() const { return valid; }
+
+    void Invalidate() { valid = false; }
+
+    //call after the frame is drawn
+    void Swap();
+
+    //stretches the frame just drawn over target
+    void Blit(GLuint target, int targetWidth, int targetHeight) const;
+
+    //reads back which pixels of the frame just drawn were reused
+    void Sample();
+
+    //share of reused pixels over the samples since the last reset
+    float SkipRate() const { return pixels ? (float)reused / pixels : 0.0f; }
+
+    int Samples() const { return samples; }
+
+    void ResetSamples();
+
+private:
+    GLuint fbo[3] = {0, 0, 0};
+    GLuint color[3] = {0, 0, 0};
+    GLuint aux[3] = {0, 0, 0};
+    GLuint tileFbo = 0;
+    GLuint tiles = 0;
+    int current = 0;
+    bool valid = false;
+    int width = 0;
+    int height = 0;
+    int samples = 0;
+    uint64_t reused = 0;
+    uint64_t pixels = 0;
+    std::vector<float> data;
+};
+
+#endif
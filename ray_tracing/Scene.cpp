@@ -0,0 +1,39 @@
+#include "Scene.h"
+
+#include <cstdio>
+
+namespace Scene
+{
+  //GLSL 3.30 does not convert int literals in struct constructors, so every float gets a point
+  static std::string Float(float value)
+  {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.9g", value);
+    std::string text = buffer;
+    if (text.find_first_of(".e") == std::string::npos)
+      text += ".0";
+    return text;
+  }
+
+  static std::string Vec3(const float3 &v)
+  {
+    return "vec3(" + Float(v.x) + ", " + Float(v.y) + ", " + Float(v.z) + ")";
+  }
+
+  std::string SceneShaderDefines()
+  {
+    std::string defines = "#define PRIMITIVE_NUM " + std::to_string(PRIMITIVE_NUM) + "\n#define SCENE_PRIMITIVES ";
+    for (int i = 0; i < PRIMITIVE_NUM; ++i)
+    {
+      const Primitive &prim = PRIMITIVES[i];
+      defines += (i ? ", " : "") + std::string("Primitive(") + std::to_string(prim.type) + ", " + Vec3(prim.centre) + ", " +
+                 Vec3(prim.features) + ", Material(" + Vec3(prim.material.color) + ", " + Float(prim.material.reflection) + "))";
+    }
+    defines += "\n#define LIGHTS_NUM " + std::to_string(LIGHTS_NUM) + "\n#define SCENE_LIGHTS ";
+    for (int i = 0; i < LIGHTS_NUM; ++i)
+    {
+      defines += (i ? ", " : "") + std::string("Light(") + Vec3(LIGHTS[i].pos) + ")";
+    }
+    return defines + "\n";
+  }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+
+#include "LiteMath.h"
+
+//the scene is described here once and folded at compile time; the fragment shader
+//gets the same tables as #defines (see SceneShaderDefines)
+namespace Scene
+{
+  using namespace LiteMath;
+
+  //primitive types, the values match fragment.glsl
+  enum PrimitiveType { BOX = 1, TORUS = 2, SPECIAL1 = 2, SPECIAL2 = 3, OCTAHEDRON = 4 };
+
+  struct Material
+  {
+    float3 color;
+    float reflection;
+  };
+
+  struct Primitive
+  {
+    int type;
+    float3 centre;
+    float3 features;
+    Material material;
+  };
+
+  struct Light
+  {
+    float3 pos;
+  };
+
+  //everything stands on the floor box, positions are given relative to its top
+  constexpr float4x4 FLOOR = translate4x4(float3(0.0f, -1.0f, 0.0f));
+
+  constexpr Primitive PRIMITIVES[] = {
+    { OCTAHEDRON, mul(FLOOR, float3(-2.6f,  0.0f,  1.5f)), float3(0.6f, 0.0f, 0.0f),  { float3(0.8f, 0.51f, 0.09f), 0.1f } },
+    { BOX,        mul(FLOOR, float3( 0.0f, -2.0f, -1.0f)), float3(5.0f, 0.0f, 5.0f),  { float3(0.87f, 0.87f, 0.87f), 0.0f } },
+    { TORUS,      mul(FLOOR, float3( 0.0f,  0.0f,  0.0f)), float3(1.0f, 0.3f, 0.0f),  { float3(0.93f, 0.3f, 0.002f), 0.3f } },
+    { SPECIAL1,   mul(FLOOR, float3( 0.0f,  0.0f, -3.0f)), float3(0.61f, 0.0f, 0.0f), { float3(0.3f, 0.5f, 0.87f), 0.0f } },
+    { SPECIAL1,   mul(FLOOR, float3( 0.0f,  0.0f, -3.0f)), float3(0.6f, 0.6f, 0.6f),  { float3(0.3f, 0.5f, 0.87f), 0.0f } },
+    { SPECIAL2,   mul(FLOOR, float3( 2.6f,  0.0f,  1.5f)), float3(0.8f, 0.0f, 0.0f),  { float3(0.4f, 0.9f, 0.3f), 0.0f } },
+    { SPECIAL2,   mul(FLOOR, float3( 2.6f, -0.7f,  1.5f)), float3(1.6f, 0.08f, 0.0f), { float3(0.4f, 0.9f, 0.3f), 0.0f } },
+  };
+  constexpr int PRIMITIVE_NUM = sizeof(PRIMITIVES) / sizeof(PRIMITIVES[0]);
+  static_assert(PRIMITIVE_NUM == 7, "sceneSDF in fragment.glsl combines primitives 3-6 by index");
+
+  constexpr Light LIGHTS[] = {
+    { float3(2.0f, 4.0f, 5.0f) },
+    { float3(0.0f, 4.2f, 0.0f) },
+  };
+  constexpr int LIGHTS_NUM = sizeof(LIGHTS) / sizeof(LIGHTS[0]);
+
+  constexpr float3 CAMERA_START = float3(0.0f, 4.0f, 7.0f);
+
+  //PRIMITIVE_NUM, SCENE_PRIMITIVES, LIGHTS_NUM and SCENE_LIGHTS for the fragment shader
+  std::string SceneShaderDefines();
+}
@@ -1,41 +1,46 @@
 #include "ShaderProgram.h"
+#include "AssetPack.h"
+#include "Trace.h"
 
-ShaderProgram::ShaderProgram(const std::unordered_map<GLenum, std::string> &inputShaders)
+#include <cstring>
+
+ShaderProgram::ShaderProgram(const std::unordered_map<GLenum, std::string> &inputShaders, const std::string &defines)
 {
+  TRACE_SCOPE("compile shaders");
 
   shaderProgram = glCreateProgram();
 
   if (inputShaders.find(GL_VERTEX_SHADER) != inputShaders.end())
   {
-    shaderObjects[GL_VERTEX_SHADER] = LoadShaderObject(GL_VERTEX_SHADER, inputShaders.at(GL_VERTEX_SHADER));
+    shaderObjects[GL_VERTEX_SHADER] = LoadShaderObject(GL_VERTEX_SHADER, inputShaders.at(GL_VERTEX_SHADER), defines);
     glAttachShader(shaderProgram, shaderObjects[GL_VERTEX_SHADER]);
   }
 
   if (inputShaders.find(GL_FRAGMENT_SHADER) != inputShaders.end())
   {
-    shaderObjects[GL_FRAGMENT_SHADER] = LoadShaderObject(GL_FRAGMENT_SHADER, inputShaders.at(GL_FRAGMENT_SHADER));
+    shaderObjects[GL_FRAGMENT_SHADER] = LoadShaderObject(GL_FRAGMENT_SHADER, inputShaders.at(GL_FRAGMENT_SHADER), defines);
     glAttachShader(shaderProgram, shaderObjects[GL_FRAGMENT_SHADER]);
   }
   if (inputShaders.find(GL_GEOMETRY_SHADER) != inputShaders.end())
   {
-    shaderObjects[GL_GEOMETRY_SHADER] = LoadShaderObject(GL_GEOMETRY_SHADER, inputShaders.at(GL_GEOMETRY_SHADER));
+    shaderObjects[GL_GEOMETRY_SHADER] = LoadShaderObject(GL_GEOMETRY_SHADER, inputShaders.at(GL_GEOMETRY_SHADER), defines);
     glAttachShader(shaderProgram, shaderObjects[GL_GEOMETRY_SHADER]);
   }
   if (inputShaders.find(GL_TESS_CONTROL_SHADER) != inputShaders.end())
   {
     shaderObjects[GL_TESS_CONTROL_SHADER] = LoadShaderObject(GL_TESS_CONTROL_SHADER,
-      inputShaders.at(GL_TESS_CONTROL_SHADER));
+      inputShaders.at(GL_TESS_CONTROL_SHADER), defines);
     glAttachShader(shaderProgram, shaderObjects[GL_TESS_CONTROL_SHADER]);
   }
   if (inputShaders.find(GL_TESS_EVALUATION_SHADER) != inputShaders.end())
   {
     shaderObjects[GL_TESS_EVALUATION_SHADER] = LoadShaderObject(GL_TESS_EVALUATION_SHADER,
-      inputShaders.at(GL_TESS_EVALUATION_SHADER));
+      inputShaders.at(GL_TESS_EVALUATION_SHADER), defines);
     glAttachShader(shaderProgram, shaderObjects[GL_TESS_EVALUATION_SHADER]);
   }
   if (inputShaders.find(GL_COMPUTE_SHADER) != inputShaders.end())
   {
-    shaderObjects[GL_COMPUTE_SHADER] = LoadShaderObject(GL_COMPUTE_SHADER, inputShaders.at(GL_COMPUTE_SHADER));
+    shaderObjects[GL_COMPUTE_SHADER] = LoadShaderObject(GL_COMPUTE_SHADER, inputShaders.at(GL_COMPUTE_SHADER), defines);
     glAttachShader(shaderProgram, shaderObjects[GL_COMPUTE_SHADER]);
   }
 
@@ -122,22 +127,27 @@ bool ShaderProgram::reLink()
 }
 
 
-GLuint ShaderProgram::LoadShaderObject(GLenum type, const std::string &filename)
+GLuint ShaderProgram::LoadShaderObject(GLenum type, const std::string &filename, const std::string &defines)
 {
-  std::ifstream fs(filename);
-
-  if (!fs.is_open())
+  Asset shaderText;
+  if (!LoadAsset(filename, shaderText))
   {
     std::cerr << "ERROR: Could not read shader from " << filename << std::endl;
     return 0;
   }
 
-  std::string shaderText((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
-
   GLuint newShaderObject = glCreateShader(type);
 
-  const char *shaderSrc = shaderText.c_str();
-  glShaderSource(newShaderObject, 1, &shaderSrc, nullptr);
+  const char *text = (const char*)shaderText.data;
+  size_t versionEnd = 0;
+  if (defines.size() && shaderText.size > 8 && !strncmp(text, "#version", 8))
+  {
+    const char *lineEnd = (const char*)memchr(text, '\n', shaderText.size);
+    versionEnd = lineEnd ? lineEnd - text + 1 : shaderText.size;
+  }
+  const char *shaderSrc[3] = { text, defines.c_str(), text + versionEnd };
+  GLint shaderLength[3] = { (GLint)versionEnd, (GLint)defines.size(), (GLint)(shaderText.size - versionEnd) };
+  glShaderSource(newShaderObject, 3, shaderSrc, shaderLength);
 
   glCompileShader(newShaderObject);
 
@@ -210,6 +220,30 @@ void ShaderProgram::SetUniform(const std::string &location, LiteMath::float4x4 a
   glUniformMatrix4fv(uniformLocation, 1, true, a_mat.L());
 }
 
+void ShaderProgram::SetUniform(const std::string &location, const LiteMath::float2 &value) const
+{
+  GLint uniformLocation = glGetUniformLocation(shaderProgram, location.c_str());
+  if (uniformLocation == -1)
+  {
+    std::cerr << "Uniform  " << location << " not found" << std::endl;
+    return;
+  }
+
+  glUniform2f(uniformLocation, value.x, value.y);
+}
+
+void ShaderProgram::SetUniform(const std::string &location, const LiteMath::float4 &value) const
+{
+  GLint uniformLocation = glGetUniformLocation(shaderProgram, location.c_str());
+  if (uniformLocation == -1)
+  {
+    std::cerr << "Uniform  " << location << " not found" << std::endl;
+    return;
+  }
+
+  glUniform4f(uniformLocation, value.x, value.y, value.z, value.w);
+}
+
 void ShaderProgram::SetUniform(const std::string &location, double value) const
 {
   GLint uniformLocation = glGetUniformLocation(shaderProgram, location.c_str());
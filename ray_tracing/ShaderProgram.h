@@ -12,7 +12,8 @@ public:
 
   ShaderProgram() : shaderProgram(-1) {};
 
-  ShaderProgram(const std::unordered_map<GLenum, std::string> &inputShaders);
+  //defines are inserted right after the #version line of every stage
+  ShaderProgram(const std::unordered_map<GLenum, std::string> &inputShaders, const std::string &defines = "");
 
   virtual ~ShaderProgram() {};
 
@@ -36,8 +37,12 @@ public:
 
   void SetUniform(const std::string &location, LiteMath::float4x4) const;
 
+  void SetUniform(const std::string &location, const LiteMath::float2 &value) const;
+
+  void SetUniform(const std::string &location, const LiteMath::float4 &value) const;
+
 private:
-  static GLuint LoadShaderObject(GLenum type, const std::string &filename);
+  static GLuint LoadShaderObject(GLenum type, const std::string &filename, const std::string &defines);
 
   GLuint shaderProgram;
   std::unordered_map<GLenum, GLuint> shaderObjects;
@@ -0,0 +1,78 @@
+#include "Simulation.h"
+#include "Trace.h"
+
+#include <chrono>
+
+void InputState::SetKey(int key, bool held)
+{
+    if (key < 0 || key >= KEYS) {
+        return;
+    }
+    uint64_t bit = (uint64_t)1 << (key % 64);
+    if (held) {
+        keys[key / 64].fetch_or(bit, std::memory_order_relaxed);
+    } else {
+        keys[key / 64].fetch_and(~bit, std::memory_order_relaxed);
+    }
+}
+
+bool InputState::Held(int key) const
+{
+    if (key < 0 || key >= KEYS) {
+        return false;
+    }
+    return (keys[key / 64].load(std::memory_order_relaxed) >> (key % 64)) & 1;
+}
+
+void InputState::SetCursor(double x, double y)
+{
+    cursorX.store(x, std::memory_order_relaxed);
+    cursorY.store(y, std::memory_order_relaxed);
+}
+
+void InputState::Cursor(double &x, double &y) const
+{
+    x = cursorX.load(std::memory_order_relaxed);
+    y = cursorY.load(std::memory_order_relaxed);
+}
+
+void InputState::Post(uint32_t newCommands)
+{
+    commands.fetch_or(newCommands, std::memory_order_relaxed);
+}
+
+uint32_t InputState::Take()
+{
+    return commands.exchange(0, std::memory_order_relaxed);
+}
+
+void FixedStepThread::Start(double rate, std::function<void(double)> step)
+{
+    Stop();
+    running = true;
+    thread = std::thread([this, rate, step]() {
+        Trace::SetThreadName("simulation");
+        std::chrono::duration<double> period(1.0 / rate);
+        std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+        while (running) {
+            {
+                TRACE_SCOPE("simulation step");
+                step(period.count());
+            }
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (now - next > std::chrono::duration<double>(maxLag)) {
+                next = now;
+            }
+            std::this_thread::sleep_until(next);
+        }
+    });
+}
+
+void FixedStepThread::Stop()
+{
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
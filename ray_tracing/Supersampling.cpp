@@ -0,0 +1,117 @@
+#include "Supersampling.h"
+
+#include <iostream>
+
+bool Supersampling::Init(int newWidth, int newHeight)
+{
+    Release();
+    width = newWidth;
+    height = newHeight;
+    glGenTextures(1, &color);
+    glBindTexture(GL_TEXTURE_2D, color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glGenTextures(1, &hits);
+    glBindTexture(GL_TEXTURE_2D, hits);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenRenderbuffers(1, &stencil);
+    glBindRenderbuffer(GL_RENDERBUFFER, stencil);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, hits, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, stencil);
+    GLenum buffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, buffers);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    //the edge pass samples the colour and the hits, so it must not have them attached
+    glGenFramebuffers(1, &edgeFbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, edgeFbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, stencil);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+    if (!complete) {
+        std::cout << "Failed to create the supersampling targets" << std::endl;
+        Release();
+        return false;
+    }
+    glGenQueries(2, queries);
+    issued[0] = issued[1] = false;
+    return true;
+}
+
+void Supersampling::Release()
+{
+    if (fbo) {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteFramebuffers(1, &edgeFbo);
+        glDeleteTextures(1, &color);
+        glDeleteTextures(1, &hits);
+        glDeleteRenderbuffers(1, &stencil);
+        fbo = edgeFbo = color = hits = stencil = 0;
+    }
+    if (queries[0]) {
+        glDeleteQueries(2, queries);
+        queries[0] = queries[1] = 0;
+    }
+}
+
+void Supersampling::BeginEdges()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, edgeFbo);
+    glClearStencil(0);
+    glClear(GL_STENCIL_BUFFER_BIT);
+    glEnable(GL_STENCIL_TEST);
+    glStencilFunc(GL_ALWAYS, 1, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+}
+
+void Supersampling::BeginSupersample()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    glStencilFunc(GL_EQUAL, 1, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    //the first ray keeps 1 / (EXTRA_SAMPLES + 1) of the pixel
+    glEnable(GL_BLEND);
+    glBlendColor(0.0f, 0.0f, 0.0f, (float)EXTRA_SAMPLES / (EXTRA_SAMPLES + 1));
+    glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+    glBeginQuery(GL_SAMPLES_PASSED, queries[parity]);
+}
+
+void Supersampling::End()
+{
+    glEndQuery(GL_SAMPLES_PASSED);
+    issued[parity] = true;
+    parity ^= 1;
+    if (issued[parity]) {
+        GLuint samples = 0;
+        glGetQueryObjectuiv(queries[parity], GL_QUERY_RESULT, &samples);
+        edgeShare = (float)samples / ((float)width * height);
+        issued[parity] = false;
+    }
+    glDisable(GL_BLEND);
+    glDisable(GL_STENCIL_TEST);
+    GLenum buffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, buffers);
+}
+
+void Supersampling::Blit(GLuint target, int targetWidth, int targetHeight) const
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, targetWidth, targetHeight, GL_COLOR_BUFFER_BIT,
+                      width == targetWidth && height == targetHeight ? GL_NEAREST : GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+}
@@ -0,0 +1,59 @@
+#ifndef SUPERSAMPLING_H
+#define SUPERSAMPLING_H
+
+#include "common.h"
+
+//Adaptive supersampling of the ray tracer. The first pass traces one ray per pixel into
+//the colour and primary hit attachments (the shader built with HIT_BUFFER); an edge pass
+//marks in the stencil the pixels that differ from a neighbour; the shader built with
+//SUPERSAMPLE then traces EXTRA_SAMPLES more rays for the marked pixels only, blended
+//with the first one through a constant alpha. A GL_SAMPLES_PASSED query counts them.
+class Supersampling
+{
+public:
+    static const int EXTRA_SAMPLES = 4;
+
+    bool Init(int width, int height);
+
+    void Release(); //actual destructor
+
+    int Width() const { return width; }
+
+    int Height() const { return height; }
+
+    //target of the first pass
+    GLuint Framebuffer() const { return fbo; }
+
+    GLuint Color() const { return color; }
+
+    GLuint Hits() const { return hits; }
+
+    //binds the stencil-only target, the edge shader discards what is not an edge
+    void BeginEdges();
+
+    //binds the colour target, draws only to the marked pixels and blends
+    void BeginSupersample();
+
+    void End();
+
+    //stretches the frame over target
+    void Blit(GLuint target, int targetWidth, int targetHeight) const;
+
+    //share of the pixels supersampled in the frame before the last one
+    float EdgeShare() const { return edgeShare; }
+
+private:
+    GLuint fbo = 0;
+    GLuint edgeFbo = 0;
+    GLuint color = 0;
+    GLuint hits = 0;
+    GLuint stencil = 0;
+    GLuint queries[2] = {0, 0};
+    bool issued[2] = {false, false};
+    int parity = 0;
+    int width = 0;
+    int height = 0;
+    float edgeShare = 0.0f;
+};
+
+#endif
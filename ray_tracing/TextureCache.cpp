@@ -0,0 +1,305 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//bump when the cooker output changes so stale cache entries are not picked up
+static const uint64_t COOKER_VERSION = 1;
+
+static const unsigned char KTX_IDENTIFIER[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+struct KtxHeader
+{
+    unsigned char identifier[12];
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+uint64_t HashBytes(const unsigned char *data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string CachePath(const std::string &cacheDir, uint64_t sourceHash, bool compressed)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%016llx-%s.ktx", (unsigned long long)(sourceHash ^ COOKER_VERSION), compressed ? "bc1" : "rgba");
+    return cacheDir + "/" + name;
+}
+
+static size_t LevelSize(int width, int height, bool compressed)
+{
+    if (compressed) {
+        return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8;
+    }
+    return (size_t)width * height * 4;
+}
+
+static uint16_t To565(const int color[3])
+{
+    return (uint16_t)(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255));
+}
+
+static void From565(uint16_t packed, int color[3])
+{
+    color[0] = ((packed >> 11) & 31) * 255 / 31;
+    color[1] = ((packed >> 5) & 63) * 255 / 63;
+    color[2] = (packed & 31) * 255 / 31;
+}
+
+//bounding box endpoints, good enough for albedo textures
+static void CompressBlockBC1(const unsigned char block[16][4], unsigned char *out)
+{
+    int minColor[3] = {255, 255, 255}, maxColor[3] = {0, 0, 0};
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            minColor[c] = std::min(minColor[c], (int)block[i][c]);
+            maxColor[c] = std::max(maxColor[c], (int)block[i][c]);
+        }
+    }
+    uint16_t color0 = To565(maxColor), color1 = To565(minColor);
+    uint32_t indices = 0;
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+    if (color0 != color1) {
+        int palette[4][3];
+        From565(color0, palette[0]);
+        From565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, bestDistance = 1 << 30;
+            for (int p = 0; p < 4; ++p) {
+                int distance = 0;
+                for (int c = 0; c < 3; ++c) {
+                    int d = block[i][c] - palette[p][c];
+                    distance += d * d;
+                }
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= (uint32_t)best << (2 * i);
+        }
+    }
+    out[0] = color0 & 0xff;
+    out[1] = color0 >> 8;
+    out[2] = color1 & 0xff;
+    out[3] = color1 >> 8;
+    for (int i = 0; i < 4; ++i) {
+        out[4 + i] = (indices >> (8 * i)) & 0xff;
+    }
+}
+
+static void CompressBC1(const unsigned char *rgba, int width, int height, unsigned char *out)
+{
+    unsigned char block[16][4];
+    for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4) {
+            for (int y = 0; y < 4; ++y) {
+                for (int x = 0; x < 4; ++x) {
+                    int sx = std::min(bx + x, width - 1), sy = std::min(by + y, height - 1);
+                    memcpy(block[y * 4 + x], rgba + ((size_t)sy * width + sx) * 4, 4);
+                }
+            }
+            CompressBlockBC1(block, out);
+            out += 8;
+        }
+    }
+}
+
+static void Downsample(const unsigned char *src, int width, int height, unsigned char *dst, int newWidth, int newHeight)
+{
+    for (int y = 0; y < newHeight; ++y) {
+        int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+        for (int x = 0; x < newWidth; ++x) {
+            int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+            for (int c = 0; c < 4; ++c) {
+                int sum = src[((size_t)y0 * width + x0) * 4 + c] + src[((size_t)y0 * width + x1) * 4 + c] +
+                          src[((size_t)y1 * width + x0) * 4 + c] + src[((size_t)y1 * width + x1) * 4 + c];
+                dst[((size_t)y * newWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+void CookTexture(const unsigned char *rgba, int width, int height, bool compress, CookedTexture &texture)
+{
+    texture.width = width;
+    texture.height = height;
+    texture.internalFormat = compress ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGBA8;
+    texture.levels.clear();
+    texture.storage.clear();
+    texture.file.Close();
+
+    std::vector<unsigned char> current(rgba, rgba + (size_t)width * height * 4), next;
+    std::vector<size_t> offsets;
+    int w = width, h = height;
+    while (true) {
+        size_t size = LevelSize(w, h, compress);
+        offsets.push_back(texture.storage.size());
+        texture.storage.resize(texture.storage.size() + size);
+        if (compress) {
+            CompressBC1(current.data(), w, h, texture.storage.data() + offsets.back());
+        } else {
+            memcpy(texture.storage.data() + offsets.back(), current.data(), size);
+        }
+        texture.levels.push_back({w, h, nullptr, size});
+        if (w == 1 && h == 1) {
+            break;
+        }
+        int newWidth = std::max(w / 2, 1), newHeight = std::max(h / 2, 1);
+        next.resize((size_t)newWidth * newHeight * 4);
+        Downsample(current.data(), w, h, next.data(), newWidth, newHeight);
+        current.swap(next);
+        w = newWidth;
+        h = newHeight;
+    }
+    for (size_t i = 0; i < texture.levels.size(); ++i) {
+        texture.levels[i].data = texture.storage.data() + offsets[i];
+    }
+}
+
+static void MakeDirectory(const std::string &path)
+{
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+bool WriteKtx(const std::string &path, const CookedTexture &texture)
+{
+    size_t slash = path.find_last_of("/\\");
+    if (slash != std::string::npos) {
+        MakeDirectory(path.substr(0, slash));
+    }
+    bool compressed = texture.internalFormat != GL_RGBA8;
+    KtxHeader header;
+    memcpy(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+    header.endianness = 0x04030201;
+    header.glType = compressed ? 0 : GL_UNSIGNED_BYTE;
+    header.glTypeSize = 1;
+    header.glFormat = compressed ? 0 : GL_RGBA;
+    header.glInternalFormat = texture.internalFormat;
+    header.glBaseInternalFormat = compressed ? GL_RGB : GL_RGBA;
+    header.pixelWidth = texture.width;
+    header.pixelHeight = texture.height;
+    header.pixelDepth = 0;
+    header.numberOfArrayElements = 0;
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = (uint32_t)texture.levels.size();
+    header.bytesOfKeyValueData = 0;
+
+    //write next to the target and rename, so a reader never sees half a file;
+    //render farm workers may cook the same entry at once, each writes its own file
+    std::string tmpPath = path + "." + std::to_string(getpid()) + "." +
+                          std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write((const char*)&header, sizeof(header));
+        const char padding[4] = {0, 0, 0, 0};
+        for (const TextureLevel &level : texture.levels) {
+            uint32_t imageSize = (uint32_t)level.size;
+            out.write((const char*)&imageSize, sizeof(imageSize));
+            out.write((const char*)level.data, level.size);
+            out.write(padding, (4 - level.size % 4) % 4);
+        }
+        if (!out.good()) {
+            out.close();
+            remove(tmpPath.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    //rename does not replace an existing file here
+    remove(path.c_str());
+#endif
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool LoadKtx(const std::string &path, CookedTexture &texture)
+{
+    texture.levels.clear();
+    texture.storage.clear();
+    if (!texture.file.Open(path)) {
+        return false;
+    }
+    const unsigned char *data = texture.file.Data();
+    size_t size = texture.file.Size();
+    KtxHeader header;
+    if (size < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0 || header.endianness != 0x04030201 ||
+        header.numberOfFaces != 1 || header.numberOfMipmapLevels == 0 || header.pixelDepth != 0) {
+        return false;
+    }
+    bool compressed = header.glInternalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    if (!compressed && header.glInternalFormat != GL_RGBA8) {
+        return false;
+    }
+    size_t offset = sizeof(header) + header.bytesOfKeyValueData;
+    int w = header.pixelWidth, h = header.pixelHeight;
+    for (uint32_t i = 0; i < header.numberOfMipmapLevels; ++i) {
+        uint32_t imageSize;
+        if (offset + sizeof(imageSize) > size) {
+            return false;
+        }
+        memcpy(&imageSize, data + offset, sizeof(imageSize));
+        offset += sizeof(imageSize);
+        if (imageSize != LevelSize(w, h, compressed) || offset + imageSize > size) {
+            return false;
+        }
+        texture.levels.push_back({w, h, data + offset, imageSize});
+        offset += imageSize + (4 - imageSize % 4) % 4;
+        w = std::max(w / 2, 1);
+        h = std::max(h / 2, 1);
+    }
+    texture.width = header.pixelWidth;
+    texture.height = header.pixelHeight;
+    texture.internalFormat = header.glInternalFormat;
+    return true;
+}
@@ -0,0 +1,103 @@
+#include "TgaImage.h"
+
+#include <cstring>
+
+enum TgaType
+{
+    TGA_TRUECOLOR = 2,
+    TGA_GRAYSCALE = 3,
+    TGA_RLE_TRUECOLOR = 10,
+    TGA_RLE_GRAYSCALE = 11
+};
+
+static bool DecodeRle(const unsigned char *src, const unsigned char *end, unsigned char *dst, size_t dstSize, int pixelSize)
+{
+    size_t written = 0;
+    while (written < dstSize) {
+        if (src >= end) {
+            return false;
+        }
+        unsigned char packet = *src++;
+        size_t count = (packet & 0x7f) + 1;
+        size_t bytes = count * pixelSize;
+        if (written + bytes > dstSize) {
+            return false;
+        }
+        if (packet & 0x80) {
+            if (end - src < pixelSize) {
+                return false;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                memcpy(dst + written + i * pixelSize, src, pixelSize);
+            }
+            src += pixelSize;
+        } else {
+            if ((size_t)(end - src) < bytes) {
+                return false;
+            }
+            memcpy(dst + written, src, bytes);
+            src += bytes;
+        }
+        written += bytes;
+    }
+    return true;
+}
+
+bool ParseTga(const unsigned char *data, size_t size, TgaImage &image)
+{
+    const size_t headerSize = 18;
+    if (size < headerSize) {
+        return false;
+    }
+    const unsigned char *header = data;
+    int idLength = header[0];
+    int colorMapType = header[1];
+    int imageType = header[2];
+    int colorMapLength = header[5] | (header[6] << 8);
+    int colorMapEntryBits = header[7];
+    int width = header[12] | (header[13] << 8);
+    int height = header[14] | (header[15] << 8);
+    int bitsPerPixel = header[16];
+
+    bool rle = imageType == TGA_RLE_TRUECOLOR || imageType == TGA_RLE_GRAYSCALE;
+    bool gray = imageType == TGA_GRAYSCALE || imageType == TGA_RLE_GRAYSCALE;
+    if (!gray && imageType != TGA_TRUECOLOR && imageType != TGA_RLE_TRUECOLOR) {
+        return false;
+    }
+    if ((gray && bitsPerPixel != 8) || (!gray && bitsPerPixel != 24 && bitsPerPixel != 32) || width == 0 || height == 0) {
+        return false;
+    }
+    size_t offset = headerSize + idLength;
+    if (colorMapType == 1) {
+        offset += colorMapLength * ((colorMapEntryBits + 7) / 8);
+    }
+    if (offset > size) {
+        return false;
+    }
+    int pixelSize = bitsPerPixel / 8;
+    size_t imageSize = (size_t)width * height * pixelSize;
+    if (rle) {
+        image.decoded.resize(imageSize);
+        if (!DecodeRle(data + offset, data + size, image.decoded.data(), imageSize, pixelSize)) {
+            return false;
+        }
+        image.pixels = image.decoded.data();
+    } else {
+        if (size - offset < imageSize) {
+            return false;
+        }
+        image.pixels = data + offset;
+    }
+    image.width = width;
+    image.height = height;
+    image.channels = pixelSize;
+    return true;
+}
+
+bool LoadTga(const std::string &name, TgaImage &image)
+{
+    if (!LoadAsset(name, image.asset)) {
+        return false;
+    }
+    return ParseTga(image.asset.data, image.asset.size, image);
+}
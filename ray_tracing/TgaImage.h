@@ -0,0 +1,27 @@
+#ifndef TGAIMAGE_H
+#define TGAIMAGE_H
+
+#include <string>
+#include <vector>
+
+#include "AssetPack.h"
+
+//uncompressed and RLE true-color/grayscale TGA.
+//For uncompressed files pixels points straight into the mapped asset,
+//only RLE images are expanded into the decoded buffer.
+struct TgaImage
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0; //1 - gray, 3 - BGR, 4 - BGRA
+    const unsigned char *pixels = nullptr;
+
+    std::vector<unsigned char> decoded;
+    Asset asset;
+};
+
+bool ParseTga(const unsigned char *data, size_t size, TgaImage &image);
+
+bool LoadTga(const std::string &name, TgaImage &image);
+
+#endif
@@ -0,0 +1,201 @@
+//times the LiteMath operations the renderer uses against the vendored glm.
+//The same source is built twice, with and without LITEMATH_USE_SSE, so the
+//scalar and SSE backends can be compared on the same machine.
+#define GLM_FORCE_INTRINSICS
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "LiteMath.h"
+#include "LiteMathBatch.h"
+
+using namespace LiteMath;
+
+static const int COUNT = 4096;
+static const int REPEAT = 256;
+static const int BATCH_COUNT = 1 << 20;
+static const int BATCH_REPEAT = 16;
+
+static volatile float sink;
+
+static float Random()
+{
+    return (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+template <class Func>
+static void Measure(const char *name, Func func, int count = COUNT, int repeat = REPEAT)
+{
+    func(); //warm up
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; ++i) {
+        func();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-28s %8.2f ns/op\n", name, seconds * 1e9 / ((double)repeat * count));
+}
+
+//the same work over 1M vectors stored as an array of float3 and as float3xN
+static void MeasureBatches(const float4x4 &m)
+{
+    std::vector<float3> points(BATCH_COUNT), aosOut(BATCH_COUNT);
+    std::vector<float> aosDot(BATCH_COUNT);
+    float3xN soaPoints, soaOut;
+    floatN soaDot;
+    soaPoints.resize(BATCH_COUNT);
+    for (int i = 0; i < BATCH_COUNT; ++i) {
+        points[i] = make_float3(Random(), Random(), Random());
+        soaPoints.set(i, points[i]);
+    }
+
+    Measure("AoS normalize x1M", [&] {
+        for (int i = 0; i < BATCH_COUNT; ++i) {
+            aosOut[i] = normalize(points[i]);
+        }
+    }, BATCH_COUNT, BATCH_REPEAT);
+    Measure("SoA normalize x1M", [&] { normalize(soaPoints, soaOut); }, BATCH_COUNT, BATCH_REPEAT);
+    Measure("AoS dot x1M", [&] {
+        for (int i = 0; i < BATCH_COUNT; ++i) {
+            aosDot[i] = dot(points[i], aosOut[i]);
+        }
+    }, BATCH_COUNT, BATCH_REPEAT);
+    Measure("SoA dot x1M", [&] { dot(soaPoints, soaOut, soaDot); }, BATCH_COUNT, BATCH_REPEAT);
+    Measure("AoS clamp x1M", [&] {
+        for (int i = 0; i < BATCH_COUNT; ++i) {
+            aosOut[i] = clamp(points[i], -0.5f, 0.5f);
+        }
+    }, BATCH_COUNT, BATCH_REPEAT);
+    Measure("SoA clamp x1M", [&] { clamp(soaPoints, make_float3(-0.5f, -0.5f, -0.5f), make_float3(0.5f, 0.5f, 0.5f), soaOut); }, BATCH_COUNT, BATCH_REPEAT);
+    Measure("AoS mul(mat, point) x1M", [&] {
+        for (int i = 0; i < BATCH_COUNT; ++i) {
+            float4 p = mul(m, make_float4(points[i].x, points[i].y, points[i].z, 1.0f));
+            aosOut[i] = make_float3(p.x, p.y, p.z);
+        }
+    }, BATCH_COUNT, BATCH_REPEAT);
+    Measure("SoA mul(mat, point) x1M", [&] { mul(m, soaPoints, 1.0f, soaOut); }, BATCH_COUNT, BATCH_REPEAT);
+
+    float maxError = 0.0f;
+    for (int i = 0; i < BATCH_COUNT; ++i) {
+        float3 a = aosOut[i], b = soaOut.get(i);
+        maxError = std::max(maxError, std::abs(a.x - b.x) + std::abs(a.y - b.y) + std::abs(a.z - b.z));
+    }
+    printf("max |AoS - SoA| = %g\n", maxError);
+    sink = aosDot[0] + soaDot[0];
+}
+
+int main()
+{
+    std::vector<float4x4> matrices(COUNT);
+    std::vector<float4> vectors4(COUNT);
+    std::vector<float3> vectors3(COUNT);
+    std::vector<glm::mat4> glmMatrices(COUNT);
+    std::vector<glm::vec4> glmVectors4(COUNT);
+    std::vector<glm::vec3> glmVectors3(COUNT);
+    for (int i = 0; i < COUNT; ++i) {
+        float4x4 m = mul(translate4x4(float3(Random(), Random(), Random())), mul(rotate_Y_4x4(Random()), rotate_X_4x4(Random())));
+        matrices[i] = m;
+        for (int r = 0; r < 4; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                glmMatrices[i][c][r] = m.M(c, r);
+            }
+        }
+        vectors4[i] = make_float4(Random(), Random(), Random(), 1.0f);
+        glmVectors4[i] = glm::vec4(vectors4[i].x, vectors4[i].y, vectors4[i].z, vectors4[i].w);
+        vectors3[i] = make_float3(Random(), Random(), Random());
+        glmVectors3[i] = glm::vec3(vectors3[i].x, vectors3[i].y, vectors3[i].z);
+    }
+
+#ifdef LITEMATH_SSE
+    printf("LiteMath backend: SSE\n");
+#else
+    printf("LiteMath backend: scalar\n");
+#endif
+
+    std::vector<float4x4> outMatrices(COUNT);
+    std::vector<float4> outVectors4(COUNT);
+    std::vector<float3> outVectors3(COUNT);
+    std::vector<glm::mat4> glmOutMatrices(COUNT);
+    std::vector<glm::vec4> glmOutVectors4(COUNT);
+    std::vector<glm::vec3> glmOutVectors3(COUNT);
+
+    Measure("LiteMath mul(mat, mat)", [&] {
+        for (int i = 0; i < COUNT; ++i) {
+            outMatrices[i] = mul(matrices[i], matrices[(i + 1) % COUNT]);
+        }
+    });
+    Measure("glm mat * mat", [&] {
+        for (int i = 0; i < COUNT; ++i) {
+            glmOutMatrices[i] = glmMatrices[i] * glmMatrices[(i + 1) % COUNT];
+        }
+    });
+    Measure("LiteMath mul(mat, vec4)", [&] {
+        for (int i = 0; i < COUNT; ++i) {
+            outVectors4[i] = mul(matrices[i], vectors4[i]);
+        }
+    });
+    Measure("glm mat * vec4", [&] {
+        for (int i = 0; i < COUNT; ++i) {
+            glmOutVectors4[i] = glmMatrices[i] * glmVectors4[i];
+        }
+    });
+    Measure("LiteMath transpose4x4", [&] {
+        for (int i = 0; i < COUNT; ++i) {
+            outMatrices[i] = transpose4x4(matrices[i]);
+        }
+    });
+    Measure("glm transpose", [&] {
+        for (int i = 0; i < COUNT; ++i) {
+            glmOutMatrices[i] = glm::transpose(glmMatrices[i]);
+        }
+    });
+    Measure("LiteMath inverse4x4", [&] {
+        for (int i = 0; i < COUNT; ++i) {
+            outMatrices[i] = inverse4x4(matrices[i]);
+        }
+    });
+    Measure("glm inverse", [&] {
+        for (int i = 0; i < COUNT; ++i) {
+            glmOutMatrices[i] = glm::inverse(glmMatrices[i]);
+        }
+    });
+    Measure("LiteMath normalize(cross)", [&] {
+        for (int i = 0; i < COUNT; ++i) {
+            outVectors3[i] = normalize(cross(vectors3[i], vectors3[(i + 1) % COUNT]));
+        }
+    });
+    Measure("glm normalize(cross)", [&] {
+        for (int i = 0; i < COUNT; ++i) {
+            glmOutVectors3[i] = glm::normalize(glm::cross(glmVectors3[i], glmVectors3[(i + 1) % COUNT]));
+        }
+    });
+
+    MeasureBatches(matrices[0]);
+
+    //both libraries must agree, otherwise the timings mean nothing
+    float maxError = 0.0f;
+    for (int i = 0; i < COUNT; ++i) {
+        float4x4 inv = inverse4x4(matrices[i]);
+        glm::mat4 glmInv = glm::inverse(glmMatrices[i]);
+        float4x4 product = mul(matrices[i], inv);
+        glm::mat4 glmProduct = glmMatrices[i] * glmInv;
+        for (int r = 0; r < 4; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                maxError = std::max(maxError, std::abs(inv.M(c, r) - glmInv[c][r]));
+                maxError = std::max(maxError, std::abs(product.M(c, r) - glmProduct[c][r]));
+            }
+        }
+        float3 n = cross(vectors3[i], vectors3[(i + 1) % COUNT]);
+        glm::vec3 glmN = glm::cross(glmVectors3[i], glmVectors3[(i + 1) % COUNT]);
+        maxError = std::max(maxError, std::abs(n.x - glmN.x) + std::abs(n.y - glmN.y) + std::abs(n.z - glmN.z));
+    }
+    printf("max difference from glm = %g\n", maxError);
+    sink = outMatrices[0].row[0].x + outVectors4[0].x + outVectors3[0].x +
+           glmOutMatrices[0][0][0] + glmOutVectors4[0].x + glmOutVectors3[0].x;
+    return maxError < 1e-3f ? 0 : 1;
+}
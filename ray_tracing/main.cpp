@@ -1,11 +1,34 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <thread>
+#include <cstring>
+#include <algorithm>
+#include <cstdio>
+#include <chrono>
+#include <memory>
 
 //internal includes
 #include "common.h"
 #include "ShaderProgram.h"
+#include "AssetPack.h"
 #include "LiteMath.h"
+#include "Scene.h"
+#include "TgaImage.h"
+#include "TextureCache.h"
+#include "Headless.h"
+#include "FrameSequence.h"
+#include "RenderFarm.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "Bench.h"
+#include "MarchStats.h"
+#include "DynamicResolution.h"
+#include "ReprojectionCache.h"
+#include "Supersampling.h"
+#include "Progressive.h"
+#include "RedrawGate.h"
+#include "Simulation.h"
 
 //External dependencies
 #define GLFW_DLL
@@ -13,18 +36,40 @@
 #include <random>
 
 static GLsizei WIDTH = 512, HEIGHT = 512;
+static const char *WINDOW_TITLE = "iiiii boyiiiii";
 
 using namespace LiteMath;
 
-float3 g_camPos(0, 4, 7);
+float3 g_camPos = Scene::CAMERA_START;
 float horizontal = 0;
 float vertical = - M_PI / 6;
 const float delta = 0.05;
-const float speed = 2.0;
-float3 direction;
-float3 right;
+const float speed = 3.0; //units per second
+const double SIMULATION_RATE = 120.0;
 float3 up = float3(0.0, 1.0, 0.0);
 int sharp_soft = 0;
+FrameProfiler profiler;
+std::string tracePath = "trace.json";
+int marchView = 0; //0 - the image, otherwise 1 + the MarchStats counter shown as a heat map
+bool dynamicResolution = false;
+//what the ray tracer takes from the last frame
+enum TemporalMode { TEMPORAL_OFF, TEMPORAL_REPROJECTION, TEMPORAL_CHECKERBOARD, TEMPORAL_MODES };
+int temporalMode = TEMPORAL_OFF;
+bool antialiasing = false;
+bool progressive = false;
+RedrawGate redraw;
+//the camera and the scene clock of a window are moved by the simulation thread
+struct SimState
+{
+    float3 camPos;
+    float horizontal;
+    float vertical;
+    double time;
+};
+enum SimCommand { COMMAND_RESET = 1, COMMAND_PAUSE = 2 };
+InputState input;
+TripleBuffer<SimState> simStates;
+FixedStepThread simulation;
 
 void windowResize(GLFWwindow* window, int width, int height)
 {
@@ -32,52 +77,123 @@ void windowResize(GLFWwindow* window, int width, int height)
     HEIGHT = height;
 }
 
+//the window was uncovered or resized, its contents are gone
+void windowRefresh(GLFWwindow* window)
+{
+    redraw.Request();
+}
+
 void mouseMove(GLFWwindow* window, double xpos, double ypos)
 {
-    vertical += 0.05f * delta * (HEIGHT / 2.0 - ypos);
-    horizontal += 0.05f * delta * (WIDTH / 2.0 - xpos);
+    input.SetCursor(xpos, ypos);
 }
 
-void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+//one step of the simulation thread: held keys move the camera by speed * dt
+void Simulate(SimState &state, bool &paused, double &cursorX, double &cursorY, double dt)
 {
-    direction = float3(cos(vertical) * sin(horizontal), 0.0, cos(vertical) * cos(horizontal));
-    right = float3(sin(horizontal - M_PI / 2.0f), 0, cos(horizontal - M_PI / 2.0f));
-    if (key == GLFW_KEY_W && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        g_camPos -= direction * delta * speed;
+    uint32_t commands = input.Take();
+    bool changed = commands != 0 || !paused;
+    if (commands & COMMAND_RESET) {
+        state.camPos = Scene::CAMERA_START;
+        state.vertical = - M_PI / 6;
+        state.horizontal = 0;
     }
-    if (key == GLFW_KEY_S && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        g_camPos += direction * delta * speed;
+    if (commands & COMMAND_PAUSE) {
+        paused = !paused;
     }
-    if (key == GLFW_KEY_A && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        g_camPos += right * delta * speed;
+    double x, y;
+    input.Cursor(x, y);
+    if (x != cursorX || y != cursorY) {
+        state.vertical -= 0.05f * delta * (y - cursorY);
+        state.horizontal -= 0.05f * delta * (x - cursorX);
+        cursorX = x;
+        cursorY = y;
+        changed = true;
     }
-    if (key == GLFW_KEY_D && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        g_camPos -= right * delta * speed;
+    float3 direction = float3(cos(state.vertical) * sin(state.horizontal), 0.0, cos(state.vertical) * cos(state.horizontal));
+    float3 right = float3(sin(state.horizontal - M_PI / 2.0f), 0, cos(state.horizontal - M_PI / 2.0f));
+    const int keys[6] = {GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_R, GLFW_KEY_F};
+    const float3 moves[6] = {-direction, direction, right, -right, up, -up};
+    for (int i = 0; i < 6; ++i) {
+        if (input.Held(keys[i])) {
+            state.camPos += moves[i] * speed * (float)dt;
+            changed = true;
+        }
     }
-    if (key == GLFW_KEY_R && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        g_camPos += up * delta * speed;// up *
+    if (!paused) {
+        state.time += dt;
     }
-    if (key == GLFW_KEY_F && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        g_camPos -= up * delta * speed;
+    simStates.Back() = state;
+    simStates.Publish();
+    //wakes the render loop when it waits for events
+    if (changed) {
+        glfwPostEmptyEvent();
+    }
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (action != GLFW_REPEAT) {
+        input.SetKey(key, action == GLFW_PRESS);
     }
     if (key == GLFW_KEY_0 && action == GLFW_PRESS) {
-         g_camPos = float3(0.0, 4.0, 7.0);
-         vertical = - M_PI / 6;
-         horizontal = 0;
-         sharp_soft = 0;
+        input.Post(COMMAND_RESET);
+        sharp_soft = 0;
     }
     if (key == GLFW_KEY_1 && action == GLFW_PRESS) {
         sharp_soft = (sharp_soft + 1) % 2;
     }
+    if (key == GLFW_KEY_2 && action == GLFW_PRESS) {
+        dynamicResolution = !dynamicResolution;
+        std::cout << "Dynamic resolution " << (dynamicResolution ? "on" : "off") << std::endl;
+    }
+    if (key == GLFW_KEY_3 && action == GLFW_PRESS) {
+        const char *names[TEMPORAL_MODES] = {"off", "reprojection", "checkerboard"};
+        temporalMode = (temporalMode + 1) % TEMPORAL_MODES;
+        std::cout << "Temporal reuse: " << names[temporalMode] << std::endl;
+    }
+    if (key == GLFW_KEY_4 && action == GLFW_PRESS) {
+        antialiasing = !antialiasing;
+        std::cout << "Adaptive supersampling " << (antialiasing ? "on" : "off") << std::endl;
+    }
+    if (key == GLFW_KEY_5 && action == GLFW_PRESS) {
+        progressive = !progressive;
+        std::cout << "Progressive rendering " << (progressive ? "on" : "off") << std::endl;
+    }
+    if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) {
+        input.Post(COMMAND_PAUSE);
+    }
     if (key == GLFW_KEY_C && (action == GLFW_PRESS || action == GLFW_REPEAT)){
         glfwSetWindowShouldClose(window, true);
     }
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+        profiler.SetEnabled(!profiler.Enabled());
+        std::cout << "Profiling " << (profiler.Enabled() ? "on" : "off") << std::endl;
+    }
+    if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+        //first press starts a trace, the second one writes it
+        if (Trace::Enabled()) {
+            Trace::Stop();
+            Trace::Dump(tracePath);
+        } else {
+            std::cout << "Tracing to " << tracePath << ", press P again to write it" << std::endl;
+            Trace::Start();
+            if (!profiler.Enabled()) {
+                profiler.SetEnabled(true);
+            }
+        }
+    }
+    if (key == GLFW_KEY_H && action == GLFW_PRESS) {
+        marchView = (marchView + 1) % (MarchStats::COUNTERS + 1);
+        std::cout << "Heat map: " << (marchView ? MarchStats::NAMES[marchView - 1] : "off") << std::endl;
+    }
 }
 
-int initGL()
+//the headless context loads glad itself, the window still needs it
+int initGL(bool loadFunctions)
 {
 	int res = 0;
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	if (loadFunctions && !gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
 	{
 		std::cout << "Failed to initialize OpenGL context" << std::endl;
 		return -1;
@@ -88,40 +204,81 @@ int initGL()
 	std::cout << "GLSL: "     << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
 	return 0;
 }
-unsigned char* tga_image_loading(const char* file_name, int& width, int& height)
+bool HasExtension(const char *name)
 {
-    std::ifstream in_file(file_name, std::ios::binary);
-    long image_size;
-    int color;
-    char header[18];
-    in_file.read(header, 18);
-    width = header[13] << 8 + header[12];
-    height = header[15] << 8 + header[14];
-    color = header[16] >> 3;
-    image_size = width * height * color;
-    unsigned char* tga = new unsigned char[image_size * sizeof(unsigned char)];
-    in_file.read((char *) tga, image_size);
-    in_file.close();
-    return tga;
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        if (!strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), name)) {
+            return true;
+        }
+    }
+    return false;
 }
 
-unsigned int loadCubemap(std::vector<std::string> faces)
+//takes the face from the texture cache, cooking and storing it on a miss
+bool loadCubemapFace(const std::string &path, const std::string &cacheDir, bool compress, CookedTexture &cooked)
 {
+    TgaImage image;
+    if (!LoadTga(path, image)) {
+        return false;
+    }
+    std::string cachePath = CachePath(cacheDir, HashBytes(image.asset.data, image.asset.size), compress);
+    if (LoadKtx(cachePath, cooked)) {
+        return true;
+    }
+    std::vector<unsigned char> rgba((size_t)image.width * image.height * 4);
+    for (size_t i = 0; i < (size_t)image.width * image.height; ++i) {
+        const unsigned char *pixel = image.pixels + i * image.channels;
+        if (image.channels == 1) {
+            rgba[4 * i] = rgba[4 * i + 1] = rgba[4 * i + 2] = pixel[0];
+        } else {
+            rgba[4 * i] = pixel[2];
+            rgba[4 * i + 1] = pixel[1];
+            rgba[4 * i + 2] = pixel[0];
+        }
+        rgba[4 * i + 3] = image.channels == 4 ? pixel[3] : 255;
+    }
+    CookTexture(rgba.data(), image.width, image.height, compress, cooked);
+    WriteKtx(cachePath, cooked);
+    return true;
+}
+
+unsigned int loadCubemap(std::vector<std::string> faces, const std::string &cacheDir)
+{
+    TRACE_SCOPE("load cubemap");
+    bool compress = HasExtension("GL_EXT_texture_compression_s3tc");
+    std::vector<CookedTexture> cooked(faces.size());
+    std::vector<std::thread> loaders;
+    std::vector<char> loaded(faces.size(), 0);
+    for (unsigned int i = 0; i < faces.size(); ++i) {
+        loaders.emplace_back([&, i] { loaded[i] = loadCubemapFace(faces[i], cacheDir, compress, cooked[i]); });
+    }
+    for (std::thread &loader : loaders) {
+        loader.join();
+    }
     GLuint textureID;
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-    int width, height;
+    size_t levels = cooked[0].levels.size();
     for (unsigned int i = 0; i < faces.size(); ++i) {
-        unsigned char *data = tga_image_loading(faces[i].c_str(), width, height);
-        if (data) {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, data);
-            delete[] data;
-        } else {
+        if (!loaded[i]) {
             std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-            delete[] data;
+            levels = 1;
+            continue;
+        }
+        levels = std::min(levels, cooked[i].levels.size());
+        for (size_t j = 0; j < cooked[i].levels.size(); ++j) {
+            const TextureLevel &level = cooked[i].levels[j];
+            if (cooked[i].internalFormat == GL_RGBA8) {
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, (GLint)j, GL_RGBA8, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, level.data);
+            } else {
+                glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, (GLint)j, cooked[i].internalFormat, level.width, level.height, 0, (GLsizei)level.size, level.data);
+            }
         }
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, (GLint)levels - 1);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -131,44 +288,182 @@ unsigned int loadCubemap(std::vector<std::string> faces)
 
 int main(int argc, char** argv)
 {
-	if (!glfwInit()) {
+    bool headless = false;
+    bool syncReadback = false;
+    bool profile = false;
+    bool collectMarchStats = false;
+    float frameBudget = 16.0f;
+    int progressiveSamples = 256;
+    std::string benchPath;
+    std::string baselinePath;
+    double threshold = 10.0;
+    FrameRange frames;
+    std::string cameraFile;
+    std::string outputDir = "frames";
+    FarmSettings farm;
+    int rangeStart = 0;
+    int rangeCount = -1;
+    Tile tile;
+    //a coordinator passes every option except its own to the workers
+    std::vector<std::string> workerArgs(1, argv[0]);
+    for (int i = 1; i < argc; ++i) {
+        int optionStart = i;
+        bool farmOption = false;
+        if (!strcmp(argv[i], "--headless")) {
+            headless = true;
+        } else if (!strcmp(argv[i], "--sync-readback")) {
+            syncReadback = true;
+        } else if (!strcmp(argv[i], "--profile")) {
+            profile = true;
+        } else if (!strcmp(argv[i], "--march-stats")) {
+            collectMarchStats = true;
+        } else if (!strcmp(argv[i], "--heatmap") && i + 1 < argc) {
+            marchView = std::min(std::max(atoi(argv[++i]), 0), (int)MarchStats::COUNTERS);
+        } else if (!strcmp(argv[i], "--dynamic-res") && i + 1 < argc) {
+            frameBudget = (float)atof(argv[++i]);
+            dynamicResolution = frameBudget > 0.0f;
+        } else if (!strcmp(argv[i], "--reprojection")) {
+            temporalMode = TEMPORAL_REPROJECTION;
+        } else if (!strcmp(argv[i], "--checkerboard")) {
+            temporalMode = TEMPORAL_CHECKERBOARD;
+        } else if (!strcmp(argv[i], "--aa")) {
+            antialiasing = true;
+        } else if (!strcmp(argv[i], "--idle-fps") && i + 1 < argc) {
+            redraw.idleFps = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--progressive") && i + 1 < argc) {
+            progressiveSamples = std::max(atoi(argv[++i]), 1);
+            progressive = true;
+        } else if (!strcmp(argv[i], "--bench") && i + 1 < argc) {
+            benchPath = argv[++i];
+            headless = true;
+        } else if (!strcmp(argv[i], "--baseline") && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (!strcmp(argv[i], "--threshold") && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            tracePath = argv[++i];
+            Trace::Start();
+        } else if (!strcmp(argv[i], "--size") && i + 1 < argc) {
+            sscanf(argv[++i], "%dx%d", &WIDTH, &HEIGHT);
+        } else if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames.count = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--time") && i + 1 < argc) {
+            sscanf(argv[++i], "%lf:%lf", &frames.start, &frames.end);
+        } else if (!strcmp(argv[i], "--fps") && i + 1 < argc) {
+            frames.fps = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--camera") && i + 1 < argc) {
+            cameraFile = argv[++i];
+        } else if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+            outputDir = argv[++i];
+            farmOption = true;
+        } else if (!strcmp(argv[i], "--workers") && i + 1 < argc) {
+            farm.workers = atoi(argv[++i]);
+            farmOption = true;
+        } else if (!strcmp(argv[i], "--tiles") && i + 1 < argc) {
+            sscanf(argv[++i], "%dx%d", &farm.tilesX, &farm.tilesY);
+            farmOption = true;
+        } else if (!strcmp(argv[i], "--chunk") && i + 1 < argc) {
+            farm.chunk = atoi(argv[++i]);
+            farmOption = true;
+        } else if (!strcmp(argv[i], "--timeout") && i + 1 < argc) {
+            farm.timeout = atof(argv[++i]);
+            farmOption = true;
+        } else if (!strcmp(argv[i], "--retries") && i + 1 < argc) {
+            farm.retries = atoi(argv[++i]);
+            farmOption = true;
+        } else if (!strcmp(argv[i], "--frame-range") && i + 1 < argc) {
+            sscanf(argv[++i], "%d:%d", &rangeStart, &rangeCount);
+        } else if (!strcmp(argv[i], "--tile") && i + 1 < argc) {
+            if (!ParseTile(argv[++i], tile)) {
+                std::cout << "Expected --tile x,y,width,height" << std::endl;
+                return -1;
+            }
+        }
+        if (!farmOption) {
+            workerArgs.insert(workerArgs.end(), argv + optionStart, argv + i + 1);
+        }
+    }
+    Trace::SetThreadName("main");
+    CameraPath cameraPath;
+    if (!cameraFile.empty() && !cameraPath.Load(cameraFile)) {
         return -1;
     }
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-	glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
-    GLFWwindow*  window = glfwCreateWindow(WIDTH, HEIGHT, "iiiii boyiiiii", nullptr, nullptr);
-	if (window == nullptr)
-	{
-		std::cout << "Failed to create GLFW window" << std::endl;
-		glfwTerminate();
-		return -1;
-	}
-    glfwSetKeyCallback(window, key_callback);
-    glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
-    glfwSetCursorPosCallback (window, mouseMove);
-    glfwSetWindowSizeCallback(window, windowResize);
-	glfwMakeContextCurrent(window);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	if (initGL() != 0){
+    if (frames.fps <= 0.0) {
+        frames.fps = 60.0;
+    }
+    int frameCount = frames.FrameCount();
+    if (farm.workers > 0) {
+        return RunCoordinator(workerArgs, farm, frameCount, WIDTH, HEIGHT, outputDir) ? 0 : -1;
+    }
+    //a worker renders only part of the sequence
+    if (rangeCount >= 0) {
+        rangeStart = std::min(std::max(rangeStart, 0), frameCount);
+        frameCount = std::min(rangeCount, frameCount - rangeStart);
+    }
+    //and maybe only a tile of the WIDTH x HEIGHT frame, the vertex shader moves the quad onto it
+    int frameWidth = WIDTH, frameHeight = HEIGHT;
+    float4 tileRect(0.0f, 0.0f, 1.0f, 1.0f);
+    if (!tile.Empty()) {
+        tileRect = float4((2.0f * tile.x + tile.width) / WIDTH - 1.0f, 1.0f - (2.0f * tile.y + tile.height) / HEIGHT,
+                          (float)tile.width / WIDTH, (float)tile.height / HEIGHT);
+        WIDTH = tile.width;
+        HEIGHT = tile.height;
+    }
+    if (!OpenAssets()) {
+        std::cout << "assets.pak not found next to the executable, reading the source tree" << std::endl;
+    }
+    GLFWwindow* window = nullptr;
+    HeadlessContext offscreen;
+    if (headless) {
+        if (!offscreen.Init(WIDTH, HEIGHT)) {
+            return -1;
+        }
+    } else {
+        if (!glfwInit()) {
+            return -1;
+        }
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
+        window = glfwCreateWindow(WIDTH, HEIGHT, WINDOW_TITLE, nullptr, nullptr);
+        if (window == nullptr)
+        {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwSetKeyCallback(window, key_callback);
+        glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
+        glfwSetCursorPosCallback (window, mouseMove);
+        glfwSetWindowSizeCallback(window, windowResize);
+        glfwSetWindowRefreshCallback(window, windowRefresh);
+        glfwMakeContextCurrent(window);
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        double cursorX, cursorY;
+        glfwGetCursorPos(window, &cursorX, &cursorY);
+        input.SetCursor(cursorX, cursorY);
+    }
+	if (initGL(!headless) != 0){
         return -1;
     }
+    //frames go to the window or to the offscreen framebuffer
+    GLuint outputFBO = offscreen.Framebuffer();
 	GLenum gl_error = glGetError();
 	while (gl_error != GL_NO_ERROR){
         gl_error = glGetError();
     }
 	std::unordered_map<GLenum, std::string> shaders;
-	shaders[GL_VERTEX_SHADER]   = "vertex.glsl";
-	shaders[GL_FRAGMENT_SHADER] = "fragment.glsl";
-	ShaderProgram program(shaders);                                                                    GL_CHECK_ERRORS;
+	shaders[GL_VERTEX_SHADER]   = "shaders/vertex.glsl";
+	shaders[GL_FRAGMENT_SHADER] = "shaders/fragment.glsl";
+	ShaderProgram program(shaders, Scene::SceneShaderDefines());                                      GL_CHECK_ERRORS;
     GLuint g_vertexBufferObject;
     GLuint g_vertexArrayObject;
     std::vector<std::string> cube {
-        "../textures/front.tga", "../textures/back.tga",  "../textures/bottom.tga",
-        "../textures/top.tga", "../textures/right.tga", "../textures/left.tga"
+        "textures/front.tga", "textures/back.tga",  "textures/bottom.tga",
+        "textures/top.tga", "textures/right.tga", "textures/left.tga"
     };
-    unsigned int cubemapTexture = loadCubemap(cube);
+    unsigned int cubemapTexture = loadCubemap(cube, ExecutableDir() + "/texture_cache");
     {
         float quadPos[]=
         {
@@ -194,33 +489,493 @@ int main(int argc, char** argv)
         glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
     }
     float cur_time;
-	while (!glfwWindowShouldClose(window))
+    std::unique_ptr<FrameWriter> writer;
+    //frames are read back through a PBO ring unless --sync-readback asks for plain glReadPixels
+    ReadbackRing readback;
+    if (headless && benchPath.empty()) {
+        writer.reset(new FrameWriter());
+        if (!syncReadback && !readback.Init(WIDTH, HEIGHT)) {
+            std::cout << "Failed to create pixel buffers, reading frames synchronously" << std::endl;
+            readback.Release();
+            syncReadback = true;
+        }
+    }
+    std::vector<unsigned char> pixels;
+    int readyFrame = 0;
+    double captureTime = 0.0;
+    const int PASS_FRAME = profiler.AddPass("frame", false);
+    const int PASS_UNIFORMS = profiler.AddPass("uniforms", false);
+    const int PASS_RAY_MARCH = profiler.AddPass("ray march");
+    const int PASS_PRESENT = profiler.AddPass(!headless ? "swap" : benchPath.empty() ? "capture" : "finish", false);
+    //a trace started from the command line gets the passes too, without the console summary
+    if (Trace::Enabled() && !profile) {
+        profiler.reportInterval = 0;
+    }
+    //a benchmark keeps every frame after the warm-up and writes no images
+    const int BENCH_WARMUP = 10;
+    bool bench = !benchPath.empty();
+    if (bench) {
+        profiler.reportInterval = 0;
+        profiler.window = std::max(frameCount - BENCH_WARMUP, 1);
+    }
+    profiler.SetEnabled(profile || Trace::Enabled() || bench);
+    //the counting build of the shader and the heat map are compiled on first use
+    ShaderProgram countingProgram;
+    ShaderProgram heatmapProgram;
+    MarchStats marchStats;
+    //counts drawn red, about the 99th percentile of the starting view
+    const float HEATMAP_MAX[MarchStats::COUNTERS] = {64.0f, 128.0f, 4.0f, 256.0f};
+    DynamicResolution resolution;
+    resolution.budgetMs = frameBudget;
+    if (bench) {
+        resolution.reportInterval = 0;
+    }
+    ShaderProgram reprojectingProgram;
+    ShaderProgram resolveProgram;
+    ShaderProgram tileProgram;
+    ReprojectionCache history;
+    float4x4 prevRayMatrix;
+    int prevSharpSoft = sharp_soft;
+    int prevTemporalMode = temporalMode;
+    ShaderProgram hitProgram;
+    ShaderProgram supersampleProgram;
+    ShaderProgram edgeProgram;
+    Supersampling supersampling;
+    ShaderProgram accumulateProgram;
+    Progressive accumulation;
+    accumulation.maxSamples = progressiveSamples;
+    float4x4 lastRayMatrix;
+    float lastTime = -1.0f;
+    int lastSharpSoft = sharp_soft;
+    std::string windowTitle = WINDOW_TITLE;
+    //the temporal modes replace the pixels they reused within this many frames
+    const int SETTLE_FRAMES = 16;
+    bool converging = false;
+    double sceneTime = 0.0;
+    SimState simState = {g_camPos, horizontal, vertical, 0.0};
+    bool simPaused = false;
+    double simCursorX, simCursorY;
+    input.Cursor(simCursorX, simCursorY);
+    if (window) {
+        simulation.Start(SIMULATION_RATE, [&](double dt) { Simulate(simState, simPaused, simCursorX, simCursorY, dt); });
+    }
+    std::chrono::steady_clock::time_point loopStart = std::chrono::steady_clock::now();
+    int frame = rangeStart;
+	while (headless ? frame < rangeStart + frameCount : !glfwWindowShouldClose(window))
 	{
-        glfwSetCursorPos(window, WIDTH / 2, HEIGHT / 2);
-        glfwPollEvents();
-        program.StartUseShader();                                                                      GL_CHECK_ERRORS;
+        if (bench && frame == rangeStart + BENCH_WARMUP) {
+            profiler.SetEnabled(true);
+            marchStats.Reset();
+        }
+        if (window) {
+            if (simStates.Update()) {
+                g_camPos = simStates.Front().camPos;
+                horizontal = simStates.Front().horizontal;
+                vertical = simStates.Front().vertical;
+                sceneTime = simStates.Front().time;
+            }
+            //an unchanged scene is not drawn again, the loop sleeps until an event
+            const float view[] = {g_camPos.x, g_camPos.y, g_camPos.z, horizontal, vertical, (float)sceneTime, (float)sharp_soft,
+                                  (float)WIDTH, (float)HEIGHT, (float)marchView, (float)dynamicResolution, (float)temporalMode,
+                                  (float)antialiasing, (float)progressive};
+            if (redraw.Changed(view, sizeof(view) / sizeof(view[0]))) {
+                redraw.Request(temporalMode != TEMPORAL_OFF ? SETTLE_FRAMES : 1);
+            }
+            if (converging) {
+                redraw.Request();
+            }
+            if (!redraw.NextFrame()) {
+                TRACE_SCOPE("wait for events");
+                redraw.Wait();
+                continue;
+            }
+        }
+        profiler.Begin(PASS_FRAME);
+        if (window) {
+            TRACE_SCOPE("poll input");
+            glfwPollEvents();
+        }
+        //headless frames get their time from the frame number only, so any frame can be rendered again
+        cur_time = headless ? (float)frames.FrameTime(frame) : (float)sceneTime;
+        if (!cameraPath.Empty()) {
+            CameraKey key = cameraPath.Sample(cur_time);
+            g_camPos = float3(key.position[0], key.position[1], key.position[2]);
+            horizontal = key.yaw;
+            vertical = key.pitch;
+        }
         float4x4 camRotMatrix = mul(rotate_Y_4x4(horizontal), rotate_X_4x4(vertical));
         float4x4 camTransMatrix = translate4x4(g_camPos);
         float4x4 rayMatrix = mul(camTransMatrix, camRotMatrix);
-        program.SetUniform("g_rayMatrix", rayMatrix);
-        program.SetUniform("g_screenWidth" , WIDTH);
-        program.SetUniform("g_screenHeight", HEIGHT);
-        cur_time = glfwGetTime();
-        program.SetUniform("g_curTime", cur_time);
-        program.SetUniform("g_SharpSoft", sharp_soft);
-        glViewport(0, 0, WIDTH, HEIGHT);        GL_CHECK_ERRORS;
+        //samples add up while nothing that changes the image has changed
+        bool still = !memcmp(&rayMatrix, &lastRayMatrix, sizeof(rayMatrix)) && cur_time == lastTime && sharp_soft == lastSharpSoft;
+        lastRayMatrix = rayMatrix;
+        lastTime = cur_time;
+        lastSharpSoft = sharp_soft;
+        bool counting = collectMarchStats || marchView > 0;
+        if (counting && (marchStats.Width() != WIDTH || marchStats.Height() != HEIGHT || !marchStats.Framebuffer())) {
+            if (countingProgram.GetProgram() == (GLuint)-1) {
+                countingProgram = ShaderProgram(shaders, Scene::SceneShaderDefines() + "#define MARCH_STATS\n");
+                std::unordered_map<GLenum, std::string> heatmapShaders;
+                heatmapShaders[GL_VERTEX_SHADER]   = "shaders/vertex_FULLSCREEN.glsl";
+                heatmapShaders[GL_FRAGMENT_SHADER] = "shaders/fragment_MARCH_STATS.glsl";
+                heatmapProgram = ShaderProgram(heatmapShaders);
+            }
+            if (!marchStats.Init(WIDTH, HEIGHT)) {
+                collectMarchStats = false;
+                marchView = 0;
+                counting = false;
+            }
+        }
+        //a headless frame is accumulated to the end before it is written
+        bool accumulating = progressive && !counting;
+        if (accumulating && (accumulation.Width() != WIDTH || accumulation.Height() != HEIGHT || !accumulation.Framebuffer())) {
+            if (accumulateProgram.GetProgram() == (GLuint)-1) {
+                std::unordered_map<GLenum, std::string> accumulateShaders;
+                accumulateShaders[GL_VERTEX_SHADER]   = "shaders/vertex_FULLSCREEN.glsl";
+                accumulateShaders[GL_FRAGMENT_SHADER] = "shaders/fragment_ACCUMULATE.glsl";
+                accumulateProgram = ShaderProgram(accumulateShaders);
+            }
+            if (!accumulation.Init(WIDTH, HEIGHT)) {
+                progressive = false;
+                accumulating = false;
+            }
+        }
+        if (!accumulating || !still || headless) {
+            accumulation.Reset();
+        }
+        //tiles and the heat map are always drawn at the output size, the accumulation always at full resolution
+        bool scaled = dynamicResolution && !counting && !accumulating && tile.Empty();
+        if (scaled && (resolution.OutputWidth() != WIDTH || resolution.OutputHeight() != HEIGHT || !resolution.Framebuffer())) {
+            if (!resolution.Init(WIDTH, HEIGHT)) {
+                dynamicResolution = false;
+                scaled = false;
+            }
+        }
+        int renderWidth = scaled ? resolution.Width() : WIDTH;
+        int renderHeight = scaled ? resolution.Height() : HEIGHT;
+        bool reprojecting = temporalMode != TEMPORAL_OFF && !counting && !accumulating && tile.Empty();
+        bool checkerboard = reprojecting && temporalMode == TEMPORAL_CHECKERBOARD;
+        if (reprojecting && (history.Width() != renderWidth || history.Height() != renderHeight || !history.Framebuffer())) {
+            if (reprojectingProgram.GetProgram() == (GLuint)-1) {
+                reprojectingProgram = ShaderProgram(shaders, Scene::SceneShaderDefines() + "#define REPROJECTION\n");
+                std::unordered_map<GLenum, std::string> resolveShaders;
+                resolveShaders[GL_VERTEX_SHADER]   = "shaders/vertex_FULLSCREEN.glsl";
+                resolveShaders[GL_FRAGMENT_SHADER] = "shaders/fragment_CHECKERBOARD.glsl";
+                resolveProgram = ShaderProgram(resolveShaders);
+                std::unordered_map<GLenum, std::string> tileShaders;
+                tileShaders[GL_VERTEX_SHADER]   = "shaders/vertex_FULLSCREEN.glsl";
+                tileShaders[GL_FRAGMENT_SHADER] = "shaders/fragment_TILES.glsl";
+                tileProgram = ShaderProgram(tileShaders);
+            }
+            if (!history.Init(renderWidth, renderHeight)) {
+                temporalMode = TEMPORAL_OFF;
+                reprojecting = checkerboard = false;
+            }
+        }
+        //the shading of the history is only good for the settings it was made with
+        if (!reprojecting || sharp_soft != prevSharpSoft || temporalMode != prevTemporalMode) {
+            history.Invalidate();
+            prevSharpSoft = sharp_soft;
+            prevTemporalMode = temporalMode;
+        }
+        //the heat map and the temporal modes keep one ray per pixel
+        bool supersampled = antialiasing && !counting && !accumulating && !reprojecting;
+        if (supersampled && (supersampling.Width() != renderWidth || supersampling.Height() != renderHeight || !supersampling.Framebuffer())) {
+            if (hitProgram.GetProgram() == (GLuint)-1) {
+                hitProgram = ShaderProgram(shaders, Scene::SceneShaderDefines() + "#define HIT_BUFFER\n");
+                supersampleProgram = ShaderProgram(shaders, Scene::SceneShaderDefines() + "#define SUPERSAMPLE " +
+                                                   std::to_string(Supersampling::EXTRA_SAMPLES) + "\n");
+                std::unordered_map<GLenum, std::string> edgeShaders;
+                edgeShaders[GL_VERTEX_SHADER]   = "shaders/vertex_FULLSCREEN.glsl";
+                edgeShaders[GL_FRAGMENT_SHADER] = "shaders/fragment_EDGES.glsl";
+                edgeProgram = ShaderProgram(edgeShaders);
+            }
+            if (!supersampling.Init(renderWidth, renderHeight)) {
+                antialiasing = false;
+                supersampled = false;
+            }
+        }
+        const ShaderProgram &rayProgram = counting ? countingProgram : reprojecting ? reprojectingProgram :
+                                          supersampled ? hitProgram : program;
+        profiler.Begin(PASS_UNIFORMS);
+        rayProgram.StartUseShader();                                                                   GL_CHECK_ERRORS;
+        //every build of the ray tracing shader takes these
+        auto setRayUniforms = [&](const ShaderProgram &rays) {
+            rays.SetUniform("g_rayMatrix", rayMatrix);
+            rays.SetUniform("g_screenWidth" , tile.Empty() ? renderWidth : frameWidth);
+            rays.SetUniform("g_screenHeight", tile.Empty() ? renderHeight : frameHeight);
+            rays.SetUniform("g_tile", tileRect);
+            rays.SetUniform("g_curTime", cur_time);
+            rays.SetUniform("g_SharpSoft", sharp_soft);
+            rays.SetUniform("g_jitter", float2(0.0f, 0.0f));
+        };
+        setRayUniforms(rayProgram);
+        if (reprojecting) {
+            rayProgram.SetUniform("g_prevRayMatrix", prevRayMatrix);
+            rayProgram.SetUniform("g_historyValid", history.Valid() ? 1 : 0);
+            rayProgram.SetUniform("g_frameIndex", frame);
+            rayProgram.SetUniform("g_checkerboard", checkerboard ? 1 : 0);
+            rayProgram.SetUniform("g_historyColor", 1);
+            rayProgram.SetUniform("g_historyAux", 2);
+            rayProgram.SetUniform("g_reuseTiles", 3);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, history.HistoryColor());
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, history.HistoryAux());
+            glActiveTexture(GL_TEXTURE3);
+            glBindTexture(GL_TEXTURE_2D, history.Tiles());
+            glActiveTexture(GL_TEXTURE0);
+        }
+        profiler.End(PASS_UNIFORMS);
+        profiler.Begin(PASS_RAY_MARCH);
+        if (reprojecting && !checkerboard && history.Valid()) {
+            //which blocks are moved from the last frame, before the rays that read it
+            glBindFramebuffer(GL_FRAMEBUFFER, history.TileFramebuffer());
+            glViewport(0, 0, history.TilesWidth(), history.TilesHeight());
+            tileProgram.StartUseShader();
+            tileProgram.SetUniform("g_historyAux", 2);
+            tileProgram.SetUniform("g_frameIndex", frame);
+            glBindVertexArray(g_vertexArrayObject);
+            glEnableVertexAttribArray(0);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);  GL_CHECK_ERRORS;
+            rayProgram.StartUseShader();
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, counting ? marchStats.Framebuffer() : checkerboard ? history.RawFramebuffer() :
+                                          reprojecting ? history.Framebuffer() : supersampled ? supersampling.Framebuffer() :
+                                          scaled ? resolution.Framebuffer() : outputFBO);
+        glViewport(0, 0, checkerboard ? (renderWidth + 1) / 2 : renderWidth, renderHeight); GL_CHECK_ERRORS;
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);   GL_CHECK_ERRORS;
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
         glBindVertexArray(g_vertexArrayObject); GL_CHECK_ERRORS;
         glEnableVertexAttribArray(0);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);  GL_CHECK_ERRORS;
+        if (scaled) {
+            resolution.Begin();
+        }
+        if (accumulating) {
+            //a window gets one more sample per frame, a headless frame all of them
+            while (!accumulation.Converged()) {
+                float2 jitter;
+                accumulation.NextJitter(jitter.x, jitter.y);
+                rayProgram.SetUniform("g_jitter", jitter);
+                accumulation.BeginSample();
+                glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);  GL_CHECK_ERRORS;
+                accumulation.EndSample();
+                if (!headless) {
+                    break;
+                }
+            }
+        } else {
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);  GL_CHECK_ERRORS;
+        }
+        rayProgram.StopUseShader();
+        if (accumulating) {
+            glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+            accumulateProgram.StartUseShader();
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, accumulation.Accumulated());
+            glActiveTexture(GL_TEXTURE0);
+            accumulateProgram.SetUniform("g_accumulated", 1);
+            accumulateProgram.SetUniform("g_samples", (float)accumulation.Samples());
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);  GL_CHECK_ERRORS;
+            accumulateProgram.StopUseShader();
+        }
+        converging = accumulating && !accumulation.Converged();
+        if (scaled) {
+            resolution.End();
+            if (!reprojecting && !supersampled) {
+                resolution.Blit(outputFBO);
+            }
+        }
+        if (supersampled) {
+            //more rays only where the one ray per pixel image has edges
+            supersampling.BeginEdges();
+            edgeProgram.StartUseShader();
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, supersampling.Color());
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, supersampling.Hits());
+            glActiveTexture(GL_TEXTURE0);
+            edgeProgram.SetUniform("g_color", 1);
+            edgeProgram.SetUniform("g_hits", 2);
+            edgeProgram.SetUniform("g_colorThreshold", 0.1f);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);  GL_CHECK_ERRORS;
+            edgeProgram.StopUseShader();
+            supersampling.BeginSupersample();
+            supersampleProgram.StartUseShader();
+            setRayUniforms(supersampleProgram);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);  GL_CHECK_ERRORS;
+            supersampleProgram.StopUseShader();
+            supersampling.End();
+            supersampling.Blit(outputFBO, WIDTH, HEIGHT);
+            if (!headless && frame % 120 == 0) {
+                printf("Supersampling: %.1f%% of pixels\n", 100.0f * supersampling.EdgeShare());
+            }
+        }
+        if (checkerboard) {
+            //the untraced half of the pixels is filled in by the resolve pass
+            glBindFramebuffer(GL_FRAMEBUFFER, history.Framebuffer());
+            glViewport(0, 0, renderWidth, renderHeight);
+            resolveProgram.StartUseShader();
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, history.HistoryColor());
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, history.RawColor());
+            glActiveTexture(GL_TEXTURE3);
+            glBindTexture(GL_TEXTURE_2D, history.RawAux());
+            glActiveTexture(GL_TEXTURE0);
+            resolveProgram.SetUniform("g_historyColor", 1);
+            resolveProgram.SetUniform("g_rawColor", 2);
+            resolveProgram.SetUniform("g_rawAux", 3);
+            resolveProgram.SetUniform("g_rayMatrix", rayMatrix);
+            resolveProgram.SetUniform("g_prevRayMatrix", prevRayMatrix);
+            resolveProgram.SetUniform("g_historyValid", history.Valid() ? 1 : 0);
+            resolveProgram.SetUniform("g_frameIndex", frame);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);  GL_CHECK_ERRORS;
+            resolveProgram.StopUseShader();
+        }
+        prevRayMatrix = rayMatrix;
+        if (reprojecting) {
+            //every 10th frame that had a history
+            if (frame % 10 == 0 && history.Valid()) {
+                history.Sample();
+            }
+            history.Blit(outputFBO, WIDTH, HEIGHT);
+            history.Swap();
+            if (!headless && history.Samples() == 12) {
+                printf("%s: %.1f%% of pixels not traced\n", checkerboard ? "Checkerboard" : "Reprojection", 100.0f * history.SkipRate());
+                history.ResetSamples();
+            }
+        }
+        glViewport(0, 0, WIDTH, HEIGHT);
+        if (counting) {
+            //the image or the heat map over it goes on to the window or the capture
+            marchStats.Reduce();
+            glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+            if (marchView > 0) {
+                heatmapProgram.StartUseShader();
+                glActiveTexture(GL_TEXTURE1);
+                glBindTexture(GL_TEXTURE_2D, marchStats.ColorTexture());
+                glActiveTexture(GL_TEXTURE2);
+                glBindTexture(GL_TEXTURE_2D, marchStats.CounterTexture());
+                glActiveTexture(GL_TEXTURE0);
+                heatmapProgram.SetUniform("g_color", 1);
+                heatmapProgram.SetUniform("g_counters", 2);
+                heatmapProgram.SetUniform("g_counter", marchView - 1);
+                heatmapProgram.SetUniform("g_maxCount", HEATMAP_MAX[marchView - 1]);
+                glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);  GL_CHECK_ERRORS;
+                heatmapProgram.StopUseShader();
+            } else {
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, marchStats.Framebuffer());
+                glBlitFramebuffer(0, 0, WIDTH, HEIGHT, 0, 0, WIDTH, HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+                glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+            }
+            if (!headless && marchStats.Frames() == 120) {
+                marchStats.PrintSummary();
+                marchStats.Reset();
+            }
+        }
         glDisableVertexAttribArray(0);
         glBindVertexArray(0);                   GL_CHECK_ERRORS;
-        program.StopUseShader();
-    	glfwSwapBuffers(window);
+        profiler.End(PASS_RAY_MARCH);
+        profiler.Begin(PASS_PRESENT);
+        if (window) {
+            std::string title = WINDOW_TITLE;
+            if (accumulating) {
+                char progress[64];
+                snprintf(progress, sizeof(progress), " - %d/%d samples, %.1f s", accumulation.Samples(),
+                         accumulation.maxSamples, accumulation.Seconds());
+                title += progress;
+            }
+            if (title != windowTitle) {
+                glfwSetWindowTitle(window, title.c_str());
+                windowTitle = title;
+            }
+            glfwSwapBuffers(window);
+        } else if (bench) {
+            glFinish();
+        } else {
+            std::chrono::steady_clock::time_point captureStart = std::chrono::steady_clock::now();
+            if (syncReadback) {
+                offscreen.ReadPixels(pixels);
+                writer->Push(FramePath(outputDir, frame), WIDTH, HEIGHT, std::move(pixels));
+            } else {
+                readback.Start(outputFBO, frame);
+                while (readback.Take(pixels, readyFrame, readback.Full())) {
+                    writer->Push(FramePath(outputDir, readyFrame), WIDTH, HEIGHT, std::move(pixels));
+                }
+            }
+            captureTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - captureStart).count();
+        }
+        profiler.End(PASS_PRESENT);
+        profiler.End(PASS_FRAME);
+        profiler.EndFrame();
+        ++frame;
 	}
+    simulation.Stop();
+    if (headless && frameCount > 0 && !bench) {
+        std::chrono::steady_clock::time_point captureStart = std::chrono::steady_clock::now();
+        while (readback.Take(pixels, readyFrame, true)) {
+            writer->Push(FramePath(outputDir, readyFrame), WIDTH, HEIGHT, std::move(pixels));
+        }
+        captureTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - captureStart).count();
+        double loopTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loopStart).count();
+        std::cout << "Capture (" << (syncReadback ? "synchronous glReadPixels" : "PBO ring") << "): " << captureTime / frameCount
+                  << " ms/frame of " << loopTime / frameCount << " ms/frame" << std::endl;
+    }
+    readback.Release();
+    if (headless && profile) {
+        profiler.PrintSummary();
+    }
+    if (headless && collectMarchStats) {
+        marchStats.PrintSummary();
+    }
+    if (headless && antialiasing) {
+        printf("Supersampling: %.1f%% of pixels\n", 100.0f * supersampling.EdgeShare());
+    }
+    if (headless && progressive) {
+        printf("Progressive: %d samples per frame, %.2f s for the last one\n", accumulation.Samples(), accumulation.Seconds());
+    }
+    if (headless && history.Samples() > 0) {
+        printf("%s: %.1f%% of pixels not traced\n", temporalMode == TEMPORAL_CHECKERBOARD ? "Checkerboard" : "Reprojection",
+               100.0f * history.SkipRate());
+    }
+    int exitCode = 0;
+    if (bench) {
+        if (frameCount <= BENCH_WARMUP) {
+            std::cout << "A benchmark needs more than " << BENCH_WARMUP << " frames" << std::endl;
+            exitCode = -1;
+        } else {
+            profiler.PrintSummary();
+            if (!WriteBenchReport(benchPath, profiler, WIDTH, HEIGHT, frameCount - BENCH_WARMUP,
+                                  collectMarchStats ? marchStats.Json() : "")) {
+                exitCode = -1;
+            } else if (!baselinePath.empty() && !CompareBenchReport(baselinePath, profiler, threshold)) {
+                exitCode = -1;
+            }
+        }
+    }
+    if (Trace::Enabled()) {
+        Trace::Stop();
+        Trace::Dump(tracePath);
+    }
+    profiler.Release();
+    marchStats.Release();
+    resolution.Release();
+    history.Release();
+    supersampling.Release();
+    accumulation.Release();
 	glDeleteVertexArrays(1, &g_vertexArrayObject);
     glDeleteBuffers(1, &g_vertexBufferObject);
-	glfwTerminate();
-	return 0;
+    if (window) {
+        glfwTerminate();
+    }
+    offscreen.Release();
+    if (writer) {
+        writer->Finish();
+        if (writer->Failed()) {
+            std::cout << writer->Failed() << " frames were not written" << std::endl;
+            return -1;
+        }
+    }
+	return exitCode;
 }
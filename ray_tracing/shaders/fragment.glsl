@@ -14,6 +14,7 @@ uniform int g_screenHeight;
 uniform float4x4 g_rayMatrix;
 uniform float g_curTime;
 uniform int g_SharpSoft;
+uniform float2 g_jitter; //offset of the ray inside the pixel, in pixels
 uniform samplerCube skybox;
 
 #define BOX 1
@@ -28,6 +29,42 @@ uniform samplerCube skybox;
 #define EPS 1e-3f
 #define K 18.0
 
+#ifdef MARCH_STATS
+//debug build: the cost of every pixel goes to an RGBA32UI target (see MarchStats.h)
+layout(location = 1) out uvec4 marchStats;
+uint marchSteps = 0u;
+uint shadowSteps = 0u;
+uint bounces = 0u;
+uint sdfEvaluations = 0u;
+#define COUNT(counter) ++counter
+#else
+#define COUNT(counter)
+#endif
+
+#ifdef REPROJECTION
+#define HIT_BUFFER
+#endif
+
+#ifdef HIT_BUFFER
+//per pixel primary hit distance (-1 - sky), its primitive (-1 - sky) and 1 if the pixel was
+//not traced, for the temporal cache and the supersampling's edge detection
+layout(location = 1) out vec4 primaryHit;
+float primaryDistance = -1.0;
+int primaryPrim = -1;
+#endif
+
+#ifdef REPROJECTION
+//temporal cache (see ReprojectionCache.h): last frame's colour and primary hits
+uniform sampler2D g_historyColor;
+uniform sampler2D g_historyAux;
+uniform float4x4 g_prevRayMatrix;
+uniform int g_historyValid;
+uniform int g_frameIndex;
+uniform int g_checkerboard; //1 - only pixels with even x + y + g_frameIndex are traced into a half as wide target
+uniform sampler2D g_reuseTiles; //1 for the TILE x TILE blocks that may be moved, see fragment_TILES.glsl
+#define TILE 8
+#endif
+
 struct Material
 {
     vec3 color;
@@ -42,16 +79,8 @@ struct Primitive
     Material material;
 };
 
-#define PRIMITIVE_NUM 7
-Primitive primitive[PRIMITIVE_NUM] = Primitive[PRIMITIVE_NUM](
-    Primitive(OCTAHEDRON, vec3(-2.6, -1.0, 1.5), vec3(0.6, 0.0, 0.0), Material(vec3(0.8, 0.51, 0.09), 0.1)),
-    Primitive(BOX, vec3(0.0, -3.0, -1.0), vec3(5.0, 0.0, 5.0), Material(vec3(0.87, 0.87, 0.87), 0.0)),
-    Primitive(TORUS, vec3(0.0, -1.0, 0.0), vec3(1.0, 0.3, 0.0), Material(vec3(0.93, 0.3, 0.002), 0.3)),
-    Primitive(SPECIAL1, vec3(0.0, -1.0, -3.0), vec3(0.61, 0.0, 0.0), Material(vec3(0.3, 0.5, 0.87), 0.0)),
-    Primitive(SPECIAL1, vec3(0.0, -1.0, -3.0), vec3(0.6, 0.6, 0.6), Material(vec3(0.3, 0.5, 0.87), 0.0)),
-    Primitive(SPECIAL2, vec3(2.6, -1.0, 1.5), vec3(0.8, 0.0, 0.0), Material(vec3(0.4, 0.9, 0.3), 0.0)),
-    Primitive(SPECIAL2, vec3(2.6, -1.7, 1.5), vec3(1.6, 0.08, 0.0), Material(vec3(0.4, 0.9, 0.3), 0.0))
-    );
+//PRIMITIVE_NUM and SCENE_PRIMITIVES come from Scene.h
+Primitive primitive[PRIMITIVE_NUM] = Primitive[PRIMITIVE_NUM](SCENE_PRIMITIVES);
 
 float SDTorus(vec3 p, int prim_num)
 {
@@ -126,6 +155,7 @@ struct Hit_dist_prim
 };
 
 Hit_dist_prim sceneSDF(vec3 curPoint) {
+    COUNT(sdfEvaluations);
     Hit_dist_prim cur = Hit_dist_prim(SDOctahedron(curPoint, 0), 0);
     Hit_dist_prim tmp;
     for (int i = 1; i < PRIMITIVE_NUM - 2; ++i) {
@@ -171,6 +201,7 @@ Hit RaySceneIntersection(Ray ray)
     Hit_dist_prim curPoint;
     vec3 cur_pos;
     for (int i = 0; i < MAX_MARCHING_STEPS; ++i) {
+        COUNT(marchSteps);
         cur_pos = ray.pos + depth * ray.dir;
         curPoint = sceneSDF(cur_pos);
         if (curPoint.dist < EPS) {
@@ -189,11 +220,8 @@ struct Light
     vec3 pos;
 };
 
-#define LIGHTS_NUM 2
-Light lights[LIGHTS_NUM] = Light[LIGHTS_NUM](
-  Light(vec3(2.0f, 4.0f, 5.0f)),
-  Light(vec3(0.0f, 4.2f, 0.0f))
-  );
+//LIGHTS_NUM and SCENE_LIGHTS come from Scene.h
+Light lights[LIGHTS_NUM] = Light[LIGHTS_NUM](SCENE_LIGHTS);
 
 struct Visible_ret
 {
@@ -209,6 +237,7 @@ Visible_ret Visible(vec3 hit_point, int light_num)
     float curPoint_dist;
     float ph = 1e20;
     for (float depth = 10 * EPS; depth < t;) {
+        COUNT(shadowSteps);
         curPoint_dist = sceneSDF(hit_point + depth * dir).dist;
         if (curPoint_dist < EPS) {
             return Visible_ret(false, 0.0);
@@ -268,10 +297,17 @@ vec4 RayTrace(Ray ray)
             break;
         }
         vec3 hit_point = ray.pos + ray.dir * hit.distance;
+#ifdef HIT_BUFFER
+        if (j == 0) {
+            primaryDistance = hit.distance;
+            primaryPrim = hit.prim_num;
+        }
+#endif
         color += reflection_coeff * (1.0 - primitive[hit.prim_num].material.reflection) * All_Shades(hit_point, hit, ray.dir);
         if (primitive[hit.prim_num].material.reflection == 0.0) {
             break;
         }
+        COUNT(bounces);
         reflection_coeff *= primitive[hit.prim_num].material.reflection;
         ray.dir = normalize(reflect(normalize(ray.dir), hit.normal));
         ray.pos = hit_point;
@@ -282,18 +318,158 @@ vec4 RayTrace(Ray ray)
 float3 EyeRayDir(float x, float y, float width, float height)
 {
   float fov = 60.0f;
-  float3 ray_dir = float3(x + 0.1f - width / 2.0f, y + 0.1f - height / 2.0f, - width / tan(radians(fov) / 2.0f));
+  float3 ray_dir = float3(x - width / 2.0f, y - height / 2.0f, - width / tan(radians(fov) / 2.0f));
   return normalize(ray_dir);
 }
 
+Ray EyeRay(float x, float y, float width, float height)
+{
+    return Ray(float3x3(g_rayMatrix) * EyeRayDir(x, y, width, height), (g_rayMatrix * float4(0.0f, 0.0f, 0.0f, 1.0f)).xyz);
+}
+
+#ifdef REPROJECTION
+bool IsAnimated(int prim_num)
+{
+    return prim_num == 3 || prim_num == 5;
+}
+
+//bounding spheres of what sceneSDF moves with g_curTime: the sphere of 3 and the capsule of 5
+vec4 AnimatedBound(int i)
+{
+    if (i == 0) {
+        return vec4(primitive[3].centre, primitive[3].features[0] + 0.2);
+    }
+    float half_height = (primitive[6].features[0] + 0.3) / 2.0;
+    return vec4(primitive[6].centre + vec3(0.0, half_height, 0.0), half_height + primitive[6].features[1] + 0.08);
+}
+
+//margin widens the bounds by the reach of a soft shadow's penumbra
+bool CrossesAnimated(vec3 from, vec3 to, float margin)
+{
+    vec3 d = to - from;
+    for (int i = 0; i < 2; ++i) {
+        vec4 bound = AnimatedBound(i);
+        float t = clamp(dot(bound.xyz - from, d) / dot(d, d), 0.0, 1.0);
+        if (distance(from + t * d, bound.xyz) < bound.w + margin) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//gl_FragCoord of the previous frame's pixel that saw p: EyeRayDir and main's mapping backwards
+vec2 PreviousPixel(vec3 p, float width, float height)
+{
+    vec3 q = transpose(float3x3(g_prevRayMatrix)) * (p - g_prevRayMatrix[3].xyz);
+    if (q.z > -EPS) {
+        return vec2(-1.0);
+    }
+    float focal = width / tan(radians(60.0f) / 2.0f);
+    vec2 xy = q.xy * focal / -q.z + vec2(width, height) / 2.0;
+    vec2 texCoord = xy / vec2(width, height);
+    return ((texCoord - 0.5) / 0.8 * 0.5 + 0.5) * vec2(width, height);
+}
+
+//takes the pixel from the last frame when what it shows cannot have changed: the same
+//static, non-reflective surface (or the sky) seen from the new camera, with nothing
+//animated between it and the camera or the lights
+bool Reproject(Ray ray, float width, float height)
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(g_historyAux, 0);
+    //blocks with edges and the ones due for a refresh are traced whole
+    if (g_historyValid == 0 || texelFetch(g_reuseTiles, pixel / TILE, 0).r < 0.5) {
+        return false;
+    }
+    //the last depth of this pixel is the guess, the block shows one primitive
+    vec4 guess = texelFetch(g_historyAux, pixel, 0);
+    if (guess.y < 0.0) {
+        if (CrossesAnimated(ray.pos, ray.pos + MAX_RAY_DEPTH * ray.dir, 0.0)) {
+            return false;
+        }
+        fragColor = texture(skybox, -ray.dir);
+        primaryHit = vec4(-1.0, -1.0, 1.0, 0.0);
+        return true;
+    }
+    int prim = int(guess.y);
+    if (IsAnimated(prim) || primitive[prim].material.reflection > 0.0) {
+        return false;
+    }
+    //two sphere tracing steps from the guess put the point back on the surface
+    float depth = guess.x;
+    Hit_dist_prim surface;
+    for (int i = 0; i < 2; ++i) {
+        surface = sceneSDF(ray.pos + depth * ray.dir);
+        depth += surface.dist;
+    }
+    vec3 hit_point = ray.pos + depth * ray.dir;
+    if (surface.prim_num != prim || abs(surface.dist) > 10.0 * EPS) {
+        return false;
+    }
+    //the previous camera saw the same point
+    vec2 prev = PreviousPixel(hit_point, width, height);
+    if (any(lessThan(prev, vec2(0.0))) || any(greaterThanEqual(prev, vec2(size)))) {
+        return false;
+    }
+    vec4 prevAux = texelFetch(g_historyAux, ivec2(prev), 0);
+    if (int(prevAux.y) != prim || abs(prevAux.x - distance(g_prevRayMatrix[3].xyz, hit_point)) > 0.02 * prevAux.x + 10.0 * EPS) {
+        return false;
+    }
+    if (CrossesAnimated(ray.pos, hit_point, 0.0)) {
+        return false;
+    }
+    for (int i = 0; i < LIGHTS_NUM; ++i) {
+        float penumbra = g_SharpSoft != 0 ? distance(lights[i].pos, hit_point) / K : 0.0;
+        if (CrossesAnimated(hit_point, lights[i].pos, penumbra)) {
+            return false;
+        }
+    }
+    fragColor = texture(g_historyColor, prev / vec2(size));
+    primaryHit = vec4(depth, float(prim), 1.0, 0.0);
+    return true;
+}
+#endif
+
 void main(void)
 {
     float width = float(g_screenWidth);
     float height = float(g_screenHeight);
-    float x = fragmentTexCoord.x * width;
-    float y = fragmentTexCoord.y * height;
-    Ray ray = Ray(EyeRayDir(x, y, width, height), vec3(0.0f, 0.0f, 0.0f));
-    ray.pos = (g_rayMatrix * float4(ray.pos, 1)).xyz;
-    ray.dir = float3x3(g_rayMatrix) * ray.dir;
+    float2 texCoord = fragmentTexCoord;
+#ifdef REPROJECTION
+    //every fragment of a checkerboard frame stands for one of two neighbouring pixels of its row,
+    //so the traced ones are packed densely and the resolve pass fills the others
+    if (g_checkerboard != 0) {
+        float2 pixel = float2(2.0 * floor(gl_FragCoord.x) + float((int(gl_FragCoord.y) + g_frameIndex) & 1) + 0.5, gl_FragCoord.y);
+        texCoord = (pixel / float2(width, height) * 2.0 - 1.0) * 0.8 + 0.5;
+    }
+#endif
+    float x = texCoord.x * width;
+    float y = texCoord.y * height;
+    float2 pixelSize = float2(dFdx(x), dFdy(y));
+    x += g_jitter.x * pixelSize.x;
+    y += g_jitter.y * pixelSize.y;
+#ifdef SUPERSAMPLE
+    //edge pixels only (the stencil test): SUPERSAMPLE more rays on a rotated grid inside the pixel,
+    //blended with the first one
+    float2 offsets[4] = float2[4](float2(-0.125, -0.375), float2(0.375, -0.125), float2(0.125, 0.375), float2(-0.375, 0.125));
+    vec4 color = vec4(0.0);
+    for (int i = 0; i < SUPERSAMPLE; ++i) {
+        color += RayTrace(EyeRay(x + offsets[i % 4].x * pixelSize.x, y + offsets[i % 4].y * pixelSize.y, width, height));
+    }
+    fragColor = color / float(SUPERSAMPLE);
+    return;
+#endif
+    Ray ray = EyeRay(x, y, width, height);
+#ifdef REPROJECTION
+    if (g_checkerboard == 0 && Reproject(ray, width, height)) {
+        return;
+    }
+#endif
     fragColor = RayTrace(ray);
+#ifdef HIT_BUFFER
+    primaryHit = vec4(primaryDistance, float(primaryPrim), 0.0, 0.0);
+#endif
+#ifdef MARCH_STATS
+    marchStats = uvec4(marchSteps, shadowSteps, bounces, sdfEvaluations);
+#endif
 }
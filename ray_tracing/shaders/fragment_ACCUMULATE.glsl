@@ -0,0 +1,11 @@
+#version 330
+
+out vec4 fragColor;
+
+uniform sampler2D g_accumulated; //sum of g_samples frames
+uniform float g_samples;
+
+void main(void)
+{
+    fragColor = vec4(texelFetch(g_accumulated, ivec2(gl_FragCoord.xy), 0).rgb / g_samples, 1.0);
+}
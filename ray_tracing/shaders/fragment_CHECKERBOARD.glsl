@@ -0,0 +1,82 @@
+#version 330
+
+#define float3 vec3
+#define float4 vec4
+#define float4x4 mat4
+#define float3x3 mat3
+
+//resolve of a checkerboard frame, traced at half width (pixel x, y is in g_rawColor at x / 2, y
+//when x + y + g_frameIndex is even): traced pixels are copied, the others are moved from
+//the last frame with the camera motion and clamped to the colours of their four traced
+//neighbours, which also stand in when there is no history
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec4 primaryHit; //same as fragment.glsl: hit distance, primitive, 1 - not traced
+
+uniform sampler2D g_rawColor;
+uniform sampler2D g_rawAux;
+uniform sampler2D g_historyColor;
+uniform float4x4 g_rayMatrix;
+uniform float4x4 g_prevRayMatrix;
+uniform int g_historyValid;
+uniform int g_frameIndex;
+
+//EyeRayDir and the texture coordinates of fragment.glsl
+float3 EyeRayDir(vec2 fragCoord, vec2 size)
+{
+    vec2 xy = ((fragCoord / size * 2.0 - 1.0) * 0.8 + 0.5) * size;
+    return normalize(float3(xy - size / 2.0, - size.x / tan(radians(60.0f) / 2.0f)));
+}
+
+vec2 PreviousPixel(vec3 q, vec2 size)
+{
+    vec2 xy = q.xy * (size.x / tan(radians(60.0f) / 2.0f)) / -q.z + size / 2.0;
+    return ((xy / size - 0.5) / 0.8 * 0.5 + 0.5) * size;
+}
+
+void main(void)
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(g_historyColor, 0);
+    if (((pixel.x + pixel.y + g_frameIndex) & 1) == 0) {
+        fragColor = texelFetch(g_rawColor, ivec2(pixel.x / 2, pixel.y), 0);
+        primaryHit = texelFetch(g_rawAux, ivec2(pixel.x / 2, pixel.y), 0);
+        return;
+    }
+    ivec2 offsets[4] = ivec2[4](ivec2(1, 0), ivec2(-1, 0), ivec2(0, 1), ivec2(0, -1));
+    vec4 low = vec4(1.0), high = vec4(0.0), sum = vec4(0.0);
+    vec4 nearest = vec4(-1.0, -1.0, 1.0, 0.0);
+    float count = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        ivec2 neighbour = pixel + offsets[i];
+        if (any(lessThan(neighbour, ivec2(0))) || any(greaterThanEqual(neighbour, size))) {
+            continue;
+        }
+        vec4 color = texelFetch(g_rawColor, ivec2(neighbour.x / 2, neighbour.y), 0);
+        vec4 aux = texelFetch(g_rawAux, ivec2(neighbour.x / 2, neighbour.y), 0);
+        low = min(low, color);
+        high = max(high, color);
+        sum += color;
+        count += 1.0;
+        //the closest hit stands for the pixel's, the sky is the farthest
+        if (aux.x >= 0.0 && (nearest.x < 0.0 || aux.x < nearest.x)) {
+            nearest = vec4(aux.xy, 1.0, 0.0);
+        }
+    }
+    primaryHit = nearest;
+    fragColor = sum / max(count, 1.0);
+    if (g_historyValid == 0) {
+        return;
+    }
+    vec2 sizef = vec2(size);
+    float3 dir = float3x3(g_rayMatrix) * EyeRayDir(gl_FragCoord.xy, sizef);
+    //the sky is far enough for the rotation alone
+    float3 q = transpose(float3x3(g_prevRayMatrix)) * (nearest.x < 0.0 ? dir : g_rayMatrix[3].xyz + nearest.x * dir - g_prevRayMatrix[3].xyz);
+    if (q.z >= 0.0) {
+        return;
+    }
+    vec2 prev = PreviousPixel(q, sizef);
+    if (any(lessThan(prev, vec2(0.0))) || any(greaterThanEqual(prev, sizef))) {
+        return;
+    }
+    fragColor = clamp(texture(g_historyColor, prev / sizef), low, high);
+}
@@ -0,0 +1,36 @@
+#version 330
+
+//edge detection for the adaptive supersampling: keeps (for the stencil) the pixels that
+//show another primitive, a far different depth or colour than one of their four neighbours
+uniform sampler2D g_color;
+uniform sampler2D g_hits; //primary hit distance and primitive, both -1 for the sky, see fragment.glsl
+uniform float g_colorThreshold;
+
+bool Differs(ivec2 a, ivec2 b)
+{
+    vec4 hitA = texelFetch(g_hits, a, 0);
+    vec4 hitB = texelFetch(g_hits, b, 0);
+    if (hitA.y != hitB.y || abs(hitA.x - hitB.x) > 0.05 * max(abs(hitA.x), abs(hitB.x))) {
+        return true;
+    }
+    //the sky is a filtered texture, it does not alias
+    if (hitA.y < 0.0) {
+        return false;
+    }
+    vec3 difference = abs(texelFetch(g_color, a, 0).rgb - texelFetch(g_color, b, 0).rgb);
+    return max(difference.r, max(difference.g, difference.b)) > g_colorThreshold;
+}
+
+void main(void)
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 last = textureSize(g_hits, 0) - 1;
+    bool edge = false;
+    for (int i = 0; i < 4; ++i) {
+        ivec2 neighbour = clamp(pixel + ivec2(i == 0 ? 1 : i == 1 ? -1 : 0, i == 2 ? 1 : i == 3 ? -1 : 0), ivec2(0), last);
+        edge = edge || Differs(pixel, neighbour);
+    }
+    if (!edge) {
+        discard;
+    }
+}
@@ -0,0 +1,23 @@
+#version 330
+
+out vec4 fragColor;
+
+uniform sampler2D g_color;
+uniform usampler2D g_counters;
+uniform int g_counter;     //0 march steps, 1 shadow steps, 2 reflection bounces, 3 sceneSDF calls
+uniform float g_maxCount;  //count shown in red
+
+//blue - cyan - green - yellow - red
+vec3 HeatColor(float t)
+{
+    return clamp(1.5 - abs(4.0 * t - vec3(3.0, 2.0, 1.0)), 0.0, 1.0);
+}
+
+void main(void)
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    uint count = texelFetch(g_counters, pixel, 0)[g_counter];
+    float t = clamp(float(count) / g_maxCount, 0.0, 1.0);
+    vec3 scene = texelFetch(g_color, pixel, 0).rgb;
+    fragColor = vec4(mix(scene, HeatColor(t), 0.75), 1.0);
+}
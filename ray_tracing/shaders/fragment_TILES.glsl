@@ -0,0 +1,42 @@
+#version 330
+
+//reuse decision of the reprojection (see ReprojectionCache.h), one fragment per TILE x TILE
+//block: the block may be moved from the last frame when it and the pixels around it showed
+//one primitive (or the sky) without a break in depth, and it is not its turn to be refreshed.
+//fragment.glsl then traces or moves whole blocks, so the rays stay together
+layout(location = 0) out float reuse;
+
+uniform sampler2D g_historyAux; //primary hit distance and primitive, see fragment.glsl
+uniform int g_frameIndex;
+
+#define TILE 8
+#define REFRESH_PERIOD 16
+
+void main(void)
+{
+    ivec2 tile = ivec2(gl_FragCoord.xy);
+    reuse = 0.0;
+    //one block in REFRESH_PERIOD is traced every frame so that no shading stays stale for long
+    if ((tile.x * 7 + tile.y * 13 + g_frameIndex) % REFRESH_PERIOD == 0) {
+        return;
+    }
+    ivec2 last = textureSize(g_historyAux, 0) - 1;
+    ivec2 origin = tile * TILE - 1;
+    float prim = texelFetch(g_historyAux, clamp(origin, ivec2(0), last), 0).y;
+    float below[TILE + 2];
+    for (int y = 0; y < TILE + 2; ++y) {
+        float left = -1.0;
+        for (int x = 0; x < TILE + 2; ++x) {
+            vec4 hit = texelFetch(g_historyAux, clamp(origin + ivec2(x, y), ivec2(0), last), 0);
+            if (hit.y != prim) {
+                return;
+            }
+            if ((x > 0 && abs(hit.x - left) > 0.1 * abs(left)) || (y > 0 && abs(hit.x - below[x]) > 0.1 * abs(below[x]))) {
+                return;
+            }
+            left = hit.x;
+            below[x] = hit.x;
+        }
+    }
+    reuse = 1.0;
+}
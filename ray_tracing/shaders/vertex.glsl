@@ -4,8 +4,10 @@ layout(location = 0) in vec2 vertex;
 
 out vec2 fragmentTexCoord;
 
+uniform vec4 g_tile; //rendered part of the frame in its [-1, 1] coordinates: centre and half size
+
 void main(void)
 {
-    fragmentTexCoord = vertex * 0.8 + 0.5;
+    fragmentTexCoord = (g_tile.xy + vertex * g_tile.zw) * 0.8 + 0.5;
     gl_Position = vec4(vertex, 0.0, 1.0);
 }
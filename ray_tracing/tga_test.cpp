@@ -0,0 +1,26 @@
+//checks that LoadTga reads every cubemap face of textures/ as 512x512 BGR
+//usage: tga_test, exits with 1 when a face does not load or has other dimensions
+
+#include <iostream>
+
+#include "TgaImage.h"
+
+int main()
+{
+    const char *faces[] = {"textures/front.tga", "textures/back.tga", "textures/bottom.tga",
+                           "textures/top.tga", "textures/right.tga", "textures/left.tga"};
+    int failed = 0;
+    for (const char *face : faces) {
+        TgaImage image;
+        if (!LoadTga(face, image)) {
+            std::cout << face << ": can't load" << std::endl;
+            ++failed;
+        } else if (image.width != 512 || image.height != 512 || image.channels != 3 || !image.pixels) {
+            std::cout << face << ": " << image.width << "x" << image.height << "x" << image.channels
+                      << ", expected 512x512x3" << std::endl;
+            ++failed;
+        }
+    }
+    std::cout << (failed ? "FAILED" : "OK") << std::endl;
+    return failed ? 1 : 0;
+}
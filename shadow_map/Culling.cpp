@@ -0,0 +1,119 @@
+#include "Culling.h"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define CULLING_SSE 1
+#include <xmmintrin.h>
+#endif
+
+AABB TransformAABB(const AABB& box, const glm::mat4& model)
+{
+    glm::vec3 centre = (box.min + box.max) * 0.5f;
+    glm::vec3 extent = (box.max - box.min) * 0.5f;
+    glm::vec3 newCentre = glm::vec3(model * glm::vec4(centre, 1.0));
+    glm::vec3 newExtent;
+    for (int i = 0; i < 3; ++i) {
+        newExtent[i] = std::abs(model[0][i]) * extent.x + std::abs(model[1][i]) * extent.y + std::abs(model[2][i]) * extent.z;
+    }
+    return AABB{newCentre - newExtent, newCentre + newExtent};
+}
+
+Frustum ExtractFrustum(const glm::mat4& m)
+{
+    glm::vec4 row0 = glm::vec4(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1 = glm::vec4(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2 = glm::vec4(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3 = glm::vec4(m[0][3], m[1][3], m[2][3], m[3][3]);
+    Frustum frustum;
+    frustum.planes[0] = row3 + row0;
+    frustum.planes[1] = row3 - row0;
+    frustum.planes[2] = row3 + row1;
+    frustum.planes[3] = row3 - row1;
+    frustum.planes[4] = row3 + row2;
+    frustum.planes[5] = row3 - row2;
+    return frustum;
+}
+
+void CullingSet::Resize(size_t newCount)
+{
+    count = newCount;
+    size_t padded = (newCount + 3) & ~size_t(3);
+    cx.assign(padded, 0.0f);
+    cy.assign(padded, 0.0f);
+    cz.assign(padded, 0.0f);
+    ex.assign(padded, 0.0f);
+    ey.assign(padded, 0.0f);
+    ez.assign(padded, 0.0f);
+}
+
+void CullingSet::Set(size_t i, const AABB& box)
+{
+    glm::vec3 centre = (box.min + box.max) * 0.5f;
+    glm::vec3 extent = (box.max - box.min) * 0.5f;
+    cx[i] = centre.x;
+    cy[i] = centre.y;
+    cz[i] = centre.z;
+    ex[i] = extent.x;
+    ey[i] = extent.y;
+    ez[i] = extent.z;
+}
+
+AABB CullingSet::Get(size_t i) const
+{
+    glm::vec3 centre = glm::vec3(cx[i], cy[i], cz[i]);
+    glm::vec3 extent = glm::vec3(ex[i], ey[i], ez[i]);
+    return AABB{centre - extent, centre + extent};
+}
+
+size_t CullingSet::Cull(const Frustum& frustum, std::vector<unsigned char>& visible) const
+{
+    size_t padded = cx.size();
+    visible.resize(padded);
+    size_t visibleCount = 0;
+#ifdef CULLING_SSE
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    for (size_t i = 0; i < padded; i += 4) {
+        __m128 centreX = _mm_loadu_ps(&cx[i]);
+        __m128 centreY = _mm_loadu_ps(&cy[i]);
+        __m128 centreZ = _mm_loadu_ps(&cz[i]);
+        __m128 extentX = _mm_loadu_ps(&ex[i]);
+        __m128 extentY = _mm_loadu_ps(&ey[i]);
+        __m128 extentZ = _mm_loadu_ps(&ez[i]);
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; ++p) {
+            const glm::vec4& plane = frustum.planes[p];
+            __m128 nx = _mm_set1_ps(plane.x);
+            __m128 ny = _mm_set1_ps(plane.y);
+            __m128 nz = _mm_set1_ps(plane.z);
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, centreX), _mm_mul_ps(ny, centreY)),
+                                     _mm_add_ps(_mm_mul_ps(nz, centreZ), _mm_set1_ps(plane.w)));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nx), extentX),
+                                                  _mm_mul_ps(_mm_andnot_ps(signMask, ny), extentY)),
+                                       _mm_mul_ps(_mm_andnot_ps(signMask, nz), extentZ));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), zero));
+        }
+        int mask = _mm_movemask_ps(outside);
+        for (int j = 0; j < 4; ++j) {
+            visible[i + j] = (mask >> j) & 1 ? 0 : 1;
+        }
+    }
+#else
+    for (size_t i = 0; i < padded; ++i) {
+        bool outside = false;
+        for (int p = 0; p < 6 && !outside; ++p) {
+            const glm::vec4& plane = frustum.planes[p];
+            float dist = plane.x * cx[i] + plane.y * cy[i] + plane.z * cz[i] + plane.w;
+            float radius = std::abs(plane.x) * ex[i] + std::abs(plane.y) * ey[i] + std::abs(plane.z) * ez[i];
+            outside = dist + radius < 0.0f;
+        }
+        visible[i] = outside ? 0 : 1;
+    }
+#endif
+    visible.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
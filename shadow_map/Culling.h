@@ -0,0 +1,46 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct AABB
+{
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+AABB TransformAABB(const AABB& box, const glm::mat4& model);
+
+//planes in the form dot(n, p) + w >= 0 for points inside
+struct Frustum
+{
+    glm::vec4 planes[6];
+};
+
+Frustum ExtractFrustum(const glm::mat4& viewProjection);
+
+//world-space boxes kept as structure of arrays (centre + half extent),
+//padded to a multiple of 4 so the plane test can run on 4 boxes at a time
+class CullingSet
+{
+public:
+    void Resize(size_t count);
+
+    size_t Size() const { return count; }
+
+    void Set(size_t i, const AABB& box);
+
+    AABB Get(size_t i) const;
+
+    //fills visible[i] with 1 for boxes intersecting the frustum, returns the visible count
+    size_t Cull(const Frustum& frustum, std::vector<unsigned char>& visible) const;
+
+private:
+    size_t count = 0;
+    std::vector<float> cx, cy, cz;
+    std::vector<float> ex, ey, ez;
+};
+
+#endif
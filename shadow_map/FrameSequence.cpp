@@ -0,0 +1,137 @@
+#include "FrameSequence.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "Headless.h"
+
+bool CameraPath::Load(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file) {
+        std::cout << "Failed to open camera path " << path << std::endl;
+        return false;
+    }
+    keys.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream values(line);
+        CameraKey key;
+        if (values >> key.time >> key.position[0] >> key.position[1] >> key.position[2] >> key.yaw >> key.pitch) {
+            key.yaw *= (float)M_PI / 180.0f;
+            key.pitch *= (float)M_PI / 180.0f;
+            keys.push_back(key);
+        }
+    }
+    std::stable_sort(keys.begin(), keys.end(), [](const CameraKey &a, const CameraKey &b) { return a.time < b.time; });
+    if (keys.empty()) {
+        std::cout << "Camera path " << path << " has no keys" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static float CatmullRom(float p0, float p1, float p2, float p3, float t)
+{
+    float t2 = t * t, t3 = t2 * t;
+    return 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * (p1 - p2) + p3 - p0) * t3);
+}
+
+CameraKey CameraPath::Sample(double time) const
+{
+    if (time <= keys.front().time) {
+        return keys.front();
+    }
+    if (time >= keys.back().time) {
+        return keys.back();
+    }
+    size_t i = 1;
+    while (keys[i].time <= time) {
+        ++i;
+    }
+    const CameraKey &k0 = keys[i >= 2 ? i - 2 : 0];
+    const CameraKey &k1 = keys[i - 1];
+    const CameraKey &k2 = keys[i];
+    const CameraKey &k3 = keys[std::min(i + 1, keys.size() - 1)];
+    float t = (float)((time - k1.time) / (k2.time - k1.time));
+    CameraKey result;
+    result.time = time;
+    for (int c = 0; c < 3; ++c) {
+        result.position[c] = CatmullRom(k0.position[c], k1.position[c], k2.position[c], k3.position[c], t);
+    }
+    result.yaw = CatmullRom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, t);
+    result.pitch = CatmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, t);
+    return result;
+}
+
+int FrameRange::FrameCount() const
+{
+    if (end < 0.0) {
+        return count;
+    }
+    //the end time itself is included when it falls on a frame
+    return std::max((int)std::floor((end - start) * fps + 1e-6) + 1, 0);
+}
+
+std::string FramePath(const std::string &dir, int frame)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/frame_%04d.ppm", frame);
+    return dir + name;
+}
+
+FrameWriter::FrameWriter(size_t maxQueued) : maxQueued(std::max(maxQueued, (size_t)1))
+{
+    worker = std::thread(&FrameWriter::Worker, this);
+}
+
+FrameWriter::~FrameWriter()
+{
+    Finish();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    worker.join();
+}
+
+void FrameWriter::Push(const std::string &path, int width, int height, std::vector<unsigned char> &&rgb)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return queue.size() < maxQueued; });
+    queue.push_back(Frame{path, width, height, std::move(rgb)});
+    changed.notify_all();
+}
+
+void FrameWriter::Finish()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return queue.empty() && !busy; });
+}
+
+void FrameWriter::Worker()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        changed.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+        Frame frame = std::move(queue.front());
+        queue.pop_front();
+        busy = true;
+        changed.notify_all();
+        lock.unlock();
+        bool written = WritePPM(frame.path, frame.width, frame.height, frame.rgb.data());
+        lock.lock();
+        busy = false;
+        failed += written ? 0 : 1;
+        changed.notify_all();
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef FRAMESEQUENCE_H
+#define FRAMESEQUENCE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct CameraKey
+{
+    double time;
+    float position[3];
+    float yaw;   //radians
+    float pitch; //radians
+};
+
+//scripted camera for batch renders, a text file with one key per line:
+//  time x y z yaw pitch
+//time in seconds, angles in degrees, '#' starts a comment.
+//Between keys the camera moves along a Catmull-Rom spline.
+class CameraPath
+{
+public:
+    bool Load(const std::string &path);
+
+    bool Empty() const { return keys.empty(); }
+
+    CameraKey Sample(double time) const;
+
+private:
+    std::vector<CameraKey> keys;
+};
+
+//time of every frame in a batch render; frame i is shown at start + i / fps
+struct FrameRange
+{
+    double start = 0.0;
+    double end = -1.0; //negative: use count
+    double fps = 60.0;
+    int count = 1;
+
+    int FrameCount() const;
+
+    double FrameTime(int frame) const { return start + frame / fps; }
+};
+
+//dir/frame_NNNN.ppm
+std::string FramePath(const std::string &dir, int frame);
+
+//encodes frames on its own thread so writing overlaps with rendering;
+//Push() blocks while maxQueued frames are waiting
+class FrameWriter
+{
+public:
+    explicit FrameWriter(size_t maxQueued = 4);
+
+    ~FrameWriter();
+
+    void Push(const std::string &path, int width, int height, std::vector<unsigned char> &&rgb);
+
+    //waits until every pushed frame is on disk
+    void Finish();
+
+    int Failed() const { return failed; }
+
+private:
+    struct Frame
+    {
+        std::string path;
+        int width;
+        int height;
+        std::vector<unsigned char> rgb;
+    };
+
+    void Worker();
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Frame> queue;
+    size_t maxQueued;
+    bool busy = false;
+    bool stopping = false;
+    int failed = 0;
+};
+
+#endif
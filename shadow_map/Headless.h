@@ -0,0 +1,80 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+//OpenGL 3.3 core context without a window: EGL on Mesa's surfaceless platform
+//(or a 1x1 pbuffer where surfaceless contexts are missing) plus a framebuffer
+//object of the requested size the frames are rendered into.
+//Needs the project to be built with HAVE_EGL, otherwise Init() fails.
+class HeadlessContext
+{
+public:
+    bool Init(int width, int height);
+
+    void Release(); //actual destructor
+
+    GLuint Framebuffer() const { return fbo; }
+
+    int Width() const { return width; }
+
+    int Height() const { return height; }
+
+    //reads the colour attachment as RGB, rows from top to bottom
+    void ReadPixels(std::vector<unsigned char> &rgb) const;
+
+private:
+    void *display = nullptr;
+    void *context = nullptr;
+    void *surface = nullptr;
+    GLuint fbo = 0;
+    GLuint colorBuffer = 0;
+    GLuint depthBuffer = 0;
+    int width = 0;
+    int height = 0;
+};
+
+//Asynchronous frame capture: a ring of pixel buffer objects with a fence each.
+//Start() queues the copy of the framebuffer into the next free buffer and
+//returns at once, the pixels are mapped by Take() after the GPU signalled the
+//fence, so the copy of frame N overlaps with drawing frames N+1 and N+2.
+class ReadbackRing
+{
+public:
+    bool Init(int width, int height, int size = 3);
+
+    void Release(); //actual destructor
+
+    bool Full() const { return busy == (int)buffers.size(); }
+
+    bool Empty() const { return busy == 0; }
+
+    //the ring must not be full
+    void Start(GLuint fbo, int frame);
+
+    //the oldest copy as RGB, rows from top to bottom;
+    //without wait returns false while the GPU has not finished it
+    bool Take(std::vector<unsigned char> &rgb, int &frame, bool wait);
+
+private:
+    struct Slot
+    {
+        GLuint pbo;
+        GLsync fence;
+        int frame;
+    };
+
+    std::vector<Slot> buffers;
+    int first = 0; //oldest busy slot
+    int busy = 0;
+    int width = 0;
+    int height = 0;
+};
+
+//binary PPM, creates the parent directories when needed
+bool WritePPM(const std::string &path, int width, int height, const unsigned char *rgb);
+
+#endif
@@ -0,0 +1,192 @@
+#include "HiZ.h"
+
+#include <algorithm>
+
+void HiZBuffer::Init(int newWidth, int newHeight)
+{
+    Release();
+    width = std::max(newWidth, 1);
+    height = std::max(newHeight, 1);
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    for (Readback &readback : readbacks) {
+        glGenBuffers(1, &readback.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * sizeof(float), nullptr, GL_STREAM_READ);
+        readback.fence = 0;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    first = busy = 0;
+    valid = false;
+
+    levels.clear();
+    levelWidth.clear();
+    levelHeight.clear();
+    int w = (width + 1) / 2, h = (height + 1) / 2;
+    while (true) {
+        levels.push_back(std::vector<float>(w * h, 1.0f));
+        levelWidth.push_back(w);
+        levelHeight.push_back(h);
+        if (w == 1 && h == 1) {
+            break;
+        }
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+    }
+}
+
+void HiZBuffer::Release()
+{
+    Invalidate();
+    for (Readback &readback : readbacks) {
+        if (readback.pbo) {
+            glDeleteBuffers(1, &readback.pbo);
+            readback.pbo = 0;
+        }
+    }
+    if (fbo) {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(1, &depthTexture);
+        fbo = 0;
+        depthTexture = 0;
+    }
+}
+
+void HiZBuffer::Begin() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void HiZBuffer::End(const glm::mat4& viewProjection)
+{
+    //the newest finished read-back wins, older finished ones are dropped unread;
+    //with every slot pending the oldest is waited for
+    int newest = -1;
+    while (busy > 0) {
+        Readback &readback = readbacks[first];
+        GLenum state = glClientWaitSync(readback.fence, 0, 0);
+        while (busy == READBACKS && newest < 0 && state == GL_TIMEOUT_EXPIRED) {
+            state = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        }
+        if (state == GL_TIMEOUT_EXPIRED) {
+            break;
+        }
+        glDeleteSync(readback.fence);
+        readback.fence = 0;
+        newest = first;
+        first = (first + 1) % READBACKS;
+        --busy;
+    }
+    if (newest >= 0) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readbacks[newest].pbo);
+        const float *depth = (const float *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)width * height * sizeof(float), GL_MAP_READ_BIT);
+        if (depth) {
+            Build(depth);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            pyramidViewProjection = readbacks[newest].viewProjection;
+            valid = true;
+        }
+    }
+    Readback &readback = readbacks[(first + busy) % READBACKS];
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+    glReadPixels(0, 0, width, height, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.viewProjection = viewProjection;
+    glFlush();
+    ++busy;
+}
+
+void HiZBuffer::Invalidate()
+{
+    for (; busy > 0; --busy) {
+        glDeleteSync(readbacks[first].fence);
+        readbacks[first].fence = 0;
+        first = (first + 1) % READBACKS;
+    }
+    valid = false;
+}
+
+void HiZBuffer::Build(const float *depth)
+{
+    for (int y = 0; y < levelHeight[0]; ++y) {
+        int y0 = 2 * y, y1 = std::min(2 * y + 1, height - 1);
+        for (int x = 0; x < levelWidth[0]; ++x) {
+            int x0 = 2 * x, x1 = std::min(2 * x + 1, width - 1);
+            levels[0][y * levelWidth[0] + x] = std::max(std::max(depth[y0 * width + x0], depth[y0 * width + x1]),
+                                                        std::max(depth[y1 * width + x0], depth[y1 * width + x1]));
+        }
+    }
+    for (size_t level = 1; level < levels.size(); ++level) {
+        const std::vector<float>& src = levels[level - 1];
+        std::vector<float>& dst = levels[level];
+        int srcWidth = levelWidth[level - 1], srcHeight = levelHeight[level - 1];
+        for (int y = 0; y < levelHeight[level]; ++y) {
+            int y0 = 2 * y, y1 = std::min(2 * y + 1, srcHeight - 1);
+            for (int x = 0; x < levelWidth[level]; ++x) {
+                int x0 = 2 * x, x1 = std::min(2 * x + 1, srcWidth - 1);
+                dst[y * levelWidth[level] + x] = std::max(std::max(src[y0 * srcWidth + x0], src[y0 * srcWidth + x1]),
+                                                          std::max(src[y1 * srcWidth + x0], src[y1 * srcWidth + x1]));
+            }
+        }
+    }
+}
+
+float HiZBuffer::MaxDepth(int level, int x0, int y0, int x1, int y1) const
+{
+    const std::vector<float>& depth = levels[level];
+    float result = 0.0f;
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            result = std::max(result, depth[y * levelWidth[level] + x]);
+        }
+    }
+    return result;
+}
+
+bool HiZBuffer::IsOccluded(const AABB& box, const glm::mat4& viewProjection) const
+{
+    //an older view may not have seen what the camera sees now
+    if (!valid || viewProjection != pyramidViewProjection) {
+        return false;
+    }
+    glm::vec3 ndcMin = glm::vec3(1e30f), ndcMax = glm::vec3(-1e30f);
+    for (int i = 0; i < 8; ++i) {
+        glm::vec3 corner = glm::vec3(i & 1 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 4 ? box.max.z : box.min.z);
+        glm::vec4 clip = pyramidViewProjection * glm::vec4(corner, 1.0);
+        if (clip.w <= 1e-4f) {
+            return false;
+        }
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        ndcMin = glm::min(ndcMin, ndc);
+        ndcMax = glm::max(ndcMax, ndc);
+    }
+    float nearestDepth = ndcMin.z * 0.5f + 0.5f;
+    if (nearestDepth <= 0.0f) {
+        return false;
+    }
+    int baseWidth = levelWidth[0], baseHeight = levelHeight[0];
+    int x0 = std::min(std::max((int)((ndcMin.x * 0.5f + 0.5f) * baseWidth), 0), baseWidth - 1);
+    int x1 = std::min(std::max((int)((ndcMax.x * 0.5f + 0.5f) * baseWidth), 0), baseWidth - 1);
+    int y0 = std::min(std::max((int)((ndcMin.y * 0.5f + 0.5f) * baseHeight), 0), baseHeight - 1);
+    int y1 = std::min(std::max((int)((ndcMax.y * 0.5f + 0.5f) * baseHeight), 0), baseHeight - 1);
+    int extent = std::max(x1 - x0 + 1, y1 - y0 + 1);
+    int level = 0;
+    while ((extent >> level) > 2 && level + 1 < (int)levels.size()) {
+        ++level;
+    }
+    return nearestDepth > MaxDepth(level, x0 >> level, y0 >> level, x1 >> level, y1 >> level);
+}
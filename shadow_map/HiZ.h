@@ -0,0 +1,65 @@
+#ifndef HIZ_H
+#define HIZ_H
+
+#include <vector>
+
+#include "common.h"
+#include "Culling.h"
+
+//Full-resolution depth prepass plus a max-depth mip pyramid built on the CPU from its
+//read-back. Level 0 of the pyramid is half resolution, each texel the farthest of the
+//2x2 pixels under it, so a gap of one pixel between occluders still shows through.
+//The depth is read back through a ring of PBOs with fences: the pyramid is rebuilt from
+//the newest finished copy, usually two frames old. It only culls while the camera is
+//where it was for that copy, and the prepass must hold static occluders only.
+class HiZBuffer
+{
+public:
+    void Init(int width, int height);
+
+    void Release();
+
+    int Width() const { return width; }
+
+    int Height() const { return height; }
+
+    //binds the prepass framebuffer and clears it
+    void Begin() const;
+
+    //starts the read-back of the prepass drawn with viewProjection,
+    //rebuilds the pyramid from the newest finished one
+    void End(const glm::mat4& viewProjection);
+
+    //drops the pyramid and the pending read-backs, nothing is occluded until the next one
+    void Invalidate();
+
+    //nothing is occluded while viewProjection differs from the pyramid's
+    bool IsOccluded(const AABB& box, const glm::mat4& viewProjection) const;
+
+    static const int READBACKS = 3; //the pyramid lags the prepass by up to this many frames
+
+private:
+
+    struct Readback
+    {
+        GLuint pbo;
+        GLsync fence;
+        glm::mat4 viewProjection;
+    };
+
+    void Build(const float *depth);
+
+    float MaxDepth(int level, int x0, int y0, int x1, int y1) const;
+
+    int width = 0, height = 0;
+    GLuint fbo = 0, depthTexture = 0;
+    Readback readbacks[READBACKS] = {};
+    int first = 0; //oldest pending read-back
+    int busy = 0;
+    bool valid = false;
+    glm::mat4 pyramidViewProjection;
+    std::vector<std::vector<float> > levels;
+    std::vector<int> levelWidth, levelHeight;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#include "RedrawGate.h"
+
+#include <algorithm>
+
+#define GLFW_DLL
+#include <GLFW/glfw3.h>
+
+bool RedrawGate::Changed(const float *state, int count)
+{
+    if ((int)last.size() == count && std::equal(last.begin(), last.end(), state)) {
+        return false;
+    }
+    last.assign(state, state + count);
+    Request();
+    return true;
+}
+
+void RedrawGate::Request(int frames)
+{
+    requested = std::max(requested, frames);
+}
+
+bool RedrawGate::NextFrame()
+{
+    double now = glfwGetTime();
+    if (requested == 0 && (idleFps <= 0.0 || now - lastFrame < 1.0 / idleFps)) {
+        return false;
+    }
+    requested = std::max(requested - 1, 0);
+    lastFrame = now;
+    return true;
+}
+
+void RedrawGate::Wait() const
+{
+    if (idleFps > 0.0) {
+        glfwWaitEventsTimeout(std::max(lastFrame + 1.0 / idleFps - glfwGetTime(), 0.0));
+    } else {
+        glfwWaitEvents();
+    }
+}
@@ -1,7 +1,10 @@
 #include "ShaderProgram.h"
+#include "AssetPack.h"
+#include "Trace.h"
 
 ShaderProgram::ShaderProgram(const std::unordered_map<GLenum, std::string> &inputShaders)
 {
+  TRACE_SCOPE("compile shaders");
 
   shaderProgram = glCreateProgram();
 
@@ -124,20 +127,18 @@ bool ShaderProgram::reLink()
 
 GLuint ShaderProgram::LoadShaderObject(GLenum type, const std::string &filename)
 {
-  std::ifstream fs(filename);
-
-  if (!fs.is_open())
+  Asset shaderText;
+  if (!LoadAsset(filename, shaderText))
   {
     std::cerr << "ERROR: Could not read shader from " << filename << std::endl;
     return 0;
   }
 
-  std::string shaderText((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
-
   GLuint newShaderObject = glCreateShader(type);
 
-  const char *shaderSrc = shaderText.c_str();
-  glShaderSource(newShaderObject, 1, &shaderSrc, nullptr);
+  const char *shaderSrc = (const char*)shaderText.data;
+  GLint shaderLength = (GLint)shaderText.size;
+  glShaderSource(newShaderObject, 1, &shaderSrc, &shaderLength);
 
   glCompileShader(newShaderObject);
 
@@ -220,6 +221,17 @@ void ShaderProgram::SetUniform(const std::string &location, glm::mat4& value) co
   glUniformMatrix4fv(uniformLocation, 1, GL_FALSE, glm::value_ptr(value));
 }
 
+void ShaderProgram::SetUniform(const std::string &location, glm::mat3& value) const
+{
+  GLint uniformLocation = glGetUniformLocation(shaderProgram, location.c_str());
+  if (uniformLocation == -1)
+  {
+    std::cerr << "Uniform  " << location << " not found" << std::endl;
+    return;
+  }
+  glUniformMatrix3fv(uniformLocation, 1, GL_FALSE, glm::value_ptr(value));
+}
+
 void ShaderProgram::SetUniform(const std::string &location, glm::vec3& value) const
 {
     GLint uniformLocation = glGetUniformLocation(shaderProgram, location.c_str());
@@ -38,6 +38,8 @@ public:
 
   void SetUniform(const std::string &location, glm::mat4& value) const;
 
+  void SetUniform(const std::string &location, glm::mat3& value) const;
+
   void SetUniform(const std::string &location, glm::vec3& value) const;
 
 private:
@@ -0,0 +1,91 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+//Input as the simulation thread sees it. The window callbacks (main thread) store
+//which keys are held, the cursor position and one-shot commands; the simulation
+//thread reads them once per step, so movement follows the step rate and not the
+//key repeat rate of the OS.
+class InputState
+{
+public:
+    static const int KEYS = 512; //GLFW key codes are below this
+
+    void SetKey(int key, bool held);
+
+    bool Held(int key) const;
+
+    //the cursor of a GLFW_CURSOR_DISABLED window is unbounded, the reader takes deltas
+    void SetCursor(double x, double y);
+
+    void Cursor(double &x, double &y) const;
+
+    //commands are bits of the caller's choice, Take() returns and clears them
+    void Post(uint32_t commands);
+
+    uint32_t Take();
+
+private:
+    std::atomic<uint64_t> keys[KEYS / 64] = {};
+    std::atomic<double> cursorX{0.0};
+    std::atomic<double> cursorY{0.0};
+    std::atomic<uint32_t> commands{0};
+};
+
+//Single writer, single reader hand-off without locks: the writer fills Back() and
+//publishes it, the reader takes the newest published value with Update(); neither
+//ever waits for the other and a value is never read while it is written.
+template <typename T>
+class TripleBuffer
+{
+public:
+    T &Back() { return slots[back]; }
+
+    void Publish()
+    {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    //true when a value newer than Front() was published
+    bool Update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    const T &Front() const { return slots[front]; }
+
+private:
+    static const int INDEX = 3;
+    static const int FRESH = 4;
+
+    T slots[3];
+    std::atomic<int> middle{1};
+    int back = 0;
+    int front = 2;
+};
+
+//Calls step(dt) on a thread of its own rate times a second with a constant dt.
+//A late step is caught up at once, unless it is more than maxLag seconds late.
+class FixedStepThread
+{
+public:
+    void Start(double rate, std::function<void(double)> step);
+
+    void Stop();
+
+    double maxLag = 0.25;
+
+private:
+    std::thread thread;
+    std::atomic<bool> running{false};
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "MappedFile.h"
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+//cooked textures are KTX 1.1 files with a full mip chain, either BC1 (DXT1)
+//compressed or plain RGBA8, stored as <cache dir>/<source hash>-<format>.ktx
+
+struct TextureLevel
+{
+    int width;
+    int height;
+    const unsigned char *data;
+    size_t size;
+};
+
+struct CookedTexture
+{
+    int width = 0;
+    int height = 0;
+    GLenum internalFormat = 0; //GL_RGBA8 or GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    std::vector<TextureLevel> levels;
+
+    std::vector<unsigned char> storage; //level data of freshly cooked textures
+    MappedFile file;                    //level data of textures read from the cache
+};
+
+uint64_t HashBytes(const unsigned char *data, size_t size);
+
+std::string CachePath(const std::string &cacheDir, uint64_t sourceHash, bool compressed);
+
+//builds the mip chain from tightly packed RGBA8 pixels and compresses it when asked
+void CookTexture(const unsigned char *rgba, int width, int height, bool compress, CookedTexture &texture);
+
+bool WriteKtx(const std::string &path, const CookedTexture &texture);
+
+bool LoadKtx(const std::string &path, CookedTexture &texture);
+
+#endif
@@ -0,0 +1,177 @@
+#include "TextureLoader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "AssetPack.h"
+#include "Trace.h"
+#include "stb_image.h"
+
+static bool HasExtension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        if (!strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TextureLoader::TextureLoader(const std::string &cacheDir, unsigned int threadCount) : cacheDir(cacheDir)
+{
+    compress = HasExtension("GL_EXT_texture_compression_s3tc");
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&TextureLoader::Worker, this);
+    }
+}
+
+TextureLoader::~TextureLoader()
+{
+    StopWorkers();
+}
+
+void TextureLoader::StopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    wakeUp.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    decoded.clear();
+}
+
+void TextureLoader::Release()
+{
+    StopWorkers();
+    if (pbo) {
+        glDeleteBuffers(1, &pbo);
+        pbo = 0;
+    }
+}
+
+GLuint TextureLoader::Load(const std::string &path)
+{
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+    const unsigned char placeholder[3] = {128, 128, 128};
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, placeholder);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back({textureID, path});
+    }
+    ++pending;
+    wakeUp.notify_one();
+    return textureID;
+}
+
+void TextureLoader::Worker()
+{
+    Trace::SetThreadName("texture loader");
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) {
+                return;
+            }
+            job = jobs.front();
+            jobs.pop_front();
+        }
+        TRACE_SCOPE("decode texture");
+        Image image = {job.texture, job.path, nullptr};
+        Asset source;
+        if (LoadAsset(job.path, source)) {
+            std::shared_ptr<CookedTexture> cooked(new CookedTexture);
+            std::string cachePath = CachePath(cacheDir, HashBytes(source.data, source.size), compress);
+            if (LoadKtx(cachePath, *cooked)) {
+                image.cooked = cooked;
+            } else {
+                int width, height, channels;
+                unsigned char *pixels = stbi_load_from_memory(source.data, (int)source.size, &width, &height, &channels, 4);
+                if (pixels) {
+                    CookTexture(pixels, width, height, compress, *cooked);
+                    stbi_image_free(pixels);
+                    WriteKtx(cachePath, *cooked);
+                    image.cooked = cooked;
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        decoded.push_back(image);
+    }
+}
+
+int TextureLoader::Update()
+{
+    std::vector<Image> images;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        images.swap(decoded);
+    }
+    if (images.empty()) {
+        return 0;
+    }
+    TRACE_SCOPE("upload textures");
+    if (!pbo) {
+        glGenBuffers(1, &pbo);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    for (Image &image : images) {
+        --pending;
+        if (!image.cooked) {
+            std::cout << "Texture failed to load at path: " << image.path << std::endl;
+            continue;
+        }
+        const CookedTexture &cooked = *image.cooked;
+        GLsizeiptr size = 0;
+        for (const TextureLevel &level : cooked.levels) {
+            size += level.size;
+        }
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        unsigned char *mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!mapped) {
+            continue;
+        }
+        size_t offset = 0;
+        for (const TextureLevel &level : cooked.levels) {
+            memcpy(mapped + offset, level.data, level.size);
+            offset += level.size;
+        }
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindTexture(GL_TEXTURE_2D, image.texture);
+        offset = 0;
+        for (size_t i = 0; i < cooked.levels.size(); ++i) {
+            const TextureLevel &level = cooked.levels[i];
+            if (cooked.internalFormat == GL_RGBA8) {
+                glTexImage2D(GL_TEXTURE_2D, (GLint)i, GL_RGBA8, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, (void*)offset);
+            } else {
+                glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, cooked.internalFormat, level.width, level.height, 0, (GLsizei)level.size, (void*)offset);
+            }
+            offset += level.size;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)cooked.levels.size() - 1);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return (int)images.size();
+}
@@ -0,0 +1,67 @@
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common.h"
+#include "TextureCache.h"
+
+//loads textures on a pool of worker threads; the GL thread picks up
+//finished images in Update() and uploads them through a pixel buffer object.
+//Until then every texture holds a 1x1 grey placeholder.
+//Workers take the cooked mip chain from the cache directory when it is there
+//and otherwise decode the JPEG, cook it and store it for the next start.
+class TextureLoader
+{
+public:
+    explicit TextureLoader(const std::string &cacheDir, unsigned int threadCount = 0);
+
+    ~TextureLoader();
+
+    void Release(); //actual destructor, needs the GL context
+
+    //returns the texture name immediately, the pixels arrive later
+    GLuint Load(const std::string &path);
+
+    //uploads every image decoded so far, returns how many were uploaded
+    int Update();
+
+    bool Done() const { return pending == 0; }
+
+private:
+    struct Job
+    {
+        GLuint texture;
+        std::string path;
+    };
+
+    struct Image
+    {
+        GLuint texture;
+        std::string path;
+        std::shared_ptr<CookedTexture> cooked;
+    };
+
+    void Worker();
+
+    void StopWorkers();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::deque<Job> jobs;
+    std::vector<Image> decoded;
+    std::string cacheDir;
+    bool compress = false;
+    bool stopping = false;
+    int pending = 0;
+    GLuint pbo = 0;
+};
+
+#endif
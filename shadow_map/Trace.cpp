@@ -0,0 +1,144 @@
+#include "Trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Trace
+{
+    std::atomic<bool> recording(false);
+
+    static const uint64_t RING_SIZE = 1 << 16;
+
+    struct Event
+    {
+        const char *name;
+        uint64_t start;
+        uint64_t duration;
+    };
+
+    //written by one thread only, Dump() reads it concurrently
+    struct Ring
+    {
+        std::vector<Event> events;
+        std::atomic<uint64_t> written;
+        std::string threadName;
+        int tid;
+    };
+
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    static std::mutex registryMutex;
+    static std::vector<std::unique_ptr<Ring>> rings;
+    static thread_local Ring *threadRing = nullptr;
+    static Ring *gpuRing = nullptr;
+
+    static Ring *NewRing(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        rings.emplace_back(new Ring);
+        Ring *ring = rings.back().get();
+        ring->events.resize(RING_SIZE);
+        ring->written = 0;
+        ring->tid = (int)rings.size();
+        ring->threadName = name.empty() ? "thread " + std::to_string(ring->tid) : name;
+        return ring;
+    }
+
+    static Ring *ThreadRing()
+    {
+        if (!threadRing) {
+            threadRing = NewRing("");
+        }
+        return threadRing;
+    }
+
+    static void Push(Ring *ring, const char *name, uint64_t start, uint64_t duration)
+    {
+        uint64_t index = ring->written.load(std::memory_order_relaxed);
+        ring->events[index % RING_SIZE] = Event{name, start, duration};
+        ring->written.store(index + 1, std::memory_order_release);
+    }
+
+    void Start()
+    {
+        recording = true;
+    }
+
+    void Stop()
+    {
+        recording = false;
+    }
+
+    uint64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void SetThreadName(const char *name)
+    {
+        Ring *ring = ThreadRing();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        ring->threadName = name;
+    }
+
+    void Record(const char *name, uint64_t start, uint64_t end)
+    {
+        Push(ThreadRing(), name, start, end - start);
+    }
+
+    void RecordGpu(const char *name, uint64_t start, uint64_t duration)
+    {
+        if (!gpuRing) {
+            gpuRing = NewRing("GPU");
+        }
+        Push(gpuRing, name, start, duration);
+    }
+
+    static void WriteString(FILE *file, const std::string &text)
+    {
+        fputc('"', file);
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                fputc('\\', file);
+            }
+            fputc((unsigned char)c < 0x20 ? ' ' : c, file);
+        }
+        fputc('"', file);
+    }
+
+    bool Dump(const std::string &path)
+    {
+        FILE *file = fopen(path.c_str(), "w");
+        if (!file) {
+            printf("Failed to write %s\n", path.c_str());
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(registryMutex);
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        bool first = true;
+        size_t count = 0;
+        for (const std::unique_ptr<Ring> &ring : rings) {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",\n", ring->tid);
+            WriteString(file, ring->threadName);
+            fprintf(file, "}}");
+            first = false;
+            //when the ring has wrapped its owner may be overwriting the oldest slots right now
+            uint64_t written = ring->written.load(std::memory_order_acquire);
+            uint64_t begin = written > RING_SIZE ? written - RING_SIZE + RING_SIZE / 16 : 0;
+            for (uint64_t i = begin; i < written; ++i) {
+                const Event &event = ring->events[i % RING_SIZE];
+                fprintf(file, ",\n{\"name\":");
+                WriteString(file, event.name);
+                fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", ring->tid, event.start / 1e3, event.duration / 1e3);
+                ++count;
+            }
+        }
+        fprintf(file, "\n]}\n");
+        bool written = ferror(file) == 0;
+        fclose(file);
+        printf("Wrote %zu trace events to %s\n", count, path.c_str());
+        return written;
+    }
+}
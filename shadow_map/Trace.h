@@ -0,0 +1,59 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+//Timeline recorder for chrome://tracing and Perfetto.
+//Every thread writes complete events (name, start, duration) into its own ring
+//buffer without locks; only the first event of a thread registers the ring.
+//Names must outlive the trace: string literals or the profiler's pass names.
+//While stopped a TRACE_SCOPE costs one relaxed atomic load.
+namespace Trace
+{
+    extern std::atomic<bool> recording;
+
+    inline bool Enabled() { return recording.load(std::memory_order_relaxed); }
+
+    void Start();
+
+    void Stop();
+
+    //nanoseconds since the program started
+    uint64_t Now();
+
+    void SetThreadName(const char *name);
+
+    void Record(const char *name, uint64_t start, uint64_t end);
+
+    //GPU work is shown on a track of its own; start is the CPU time the work was submitted
+    void RecordGpu(const char *name, uint64_t start, uint64_t duration);
+
+    //writes the events still held by the rings as Chrome trace JSON
+    bool Dump(const std::string &path);
+
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name) : name(name), active(Enabled()), start(active ? Now() : 0) {}
+
+        ~Scope()
+        {
+            if (active) {
+                Record(name, start, Now());
+            }
+        }
+
+    private:
+        const char *name;
+        bool active;
+        uint64_t start;
+    };
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#endif
@@ -0,0 +1,22 @@
+//packs project files into a single archive
+//usage: assetpack <output> <root dir> <file relative to root> [...]
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "AssetPack.h"
+
+int main(int argc, char** argv)
+{
+    if (argc < 4) {
+        std::cout << "usage: assetpack <output> <root dir> <file> [<file> ...]" << std::endl;
+        return 1;
+    }
+    std::vector<std::string> names(argv + 3, argv + argc);
+    if (!WriteAssetPack(argv[1], argv[2], names)) {
+        std::cout << "Can't write asset pack " << argv[1] << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,11 +1,31 @@
 //internal includes
 #include "common.h"
 #include "ShaderProgram.h"
+#include "AssetPack.h"
+#include "Culling.h"
+#include "HiZ.h"
+#include "TextureLoader.h"
+#include "Headless.h"
+#include "FrameSequence.h"
+#include "RenderFarm.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "Bench.h"
+#include "RedrawGate.h"
+#include "Simulation.h"
 
 //External dependencies
 #define GLFW_DLL
 #include <GLFW/glfw3.h>
 #include <random>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <memory>
 
 //GLM
 #include <glm/glm.hpp>
@@ -23,12 +43,70 @@ int WIDTH = 512, HEIGHT = 512;
 float horizontal = -1.25 * M_PI;
 float vertical = -M_PI / 5;
 const float delta = 0.05;
-const float speed = 2.0;
+const float speed = 3.0; //units per second
+const double SIMULATION_RATE = 120.0;
 glm::vec3 cameraPos = glm::vec3(-4.2, 4.0,  4.5);
 glm::vec3 direction = glm::vec3(cos(vertical) * sin(horizontal), sin(vertical), cos(vertical) * cos(horizontal));
 glm::vec3 right = glm::vec3(sin(horizontal - M_PI / 2.0), 0, cos(horizontal - M_PI / 2.0));
 glm::vec3 up = glm::vec3(0.0, 1.0, 0.0);
 bool show_map = false;
+bool occlusion_culling = false;
+RedrawGate redraw;
+//the camera and the scene clock of a window are moved by the simulation thread
+struct SimState
+{
+    glm::vec3 cameraPos;
+    float horizontal;
+    float vertical;
+    double time;
+};
+enum SimCommand { COMMAND_RESET = 1, COMMAND_PAUSE = 2 };
+InputState input;
+TripleBuffer<SimState> simStates;
+FixedStepThread simulation;
+FrameProfiler profiler;
+std::string tracePath = "trace.json";
+
+struct SceneObject
+{
+    unsigned int VAO;
+    int vertexCount;
+    unsigned int texture;
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
+    AABB localBox;
+};
+
+glm::mat3 NormalMatrix(const glm::mat4& model)
+{
+    return glm::transpose(glm::inverse(glm::mat3(model)));
+}
+
+std::vector<float> SphereVertices(int segments)
+{
+    std::vector<float> vertices;
+    int rings = std::max(segments / 2, 2);
+    segments = std::max(segments, 3);
+    for (int r = 0; r < rings; ++r) {
+        for (int s = 0; s < segments; ++s) {
+            const int corners[6][2] = {{r, s}, {r + 1, s}, {r + 1, s + 1}, {r + 1, s + 1}, {r, s + 1}, {r, s}};
+            for (int c = 0; c < 6; ++c) {
+                float theta = M_PI * corners[c][0] / rings;
+                float phi = 2.0 * M_PI * corners[c][1] / segments;
+                glm::vec3 normal = glm::vec3(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi));
+                vertices.insert(vertices.end(), {normal.x, normal.y, normal.z, normal.x, normal.y, normal.z,
+                                                 (float)corners[c][1] / segments, (float)corners[c][0] / rings});
+            }
+        }
+    }
+    return vertices;
+}
+
+//the window was uncovered or resized, its contents are gone
+void windowRefresh(GLFWwindow* window)
+{
+    redraw.Request();
+}
 
 void windowResize(GLFWwindow* window, int width, int height)
 {
@@ -38,50 +116,97 @@ void windowResize(GLFWwindow* window, int width, int height)
 
 void mouseMove(GLFWwindow* window, double xpos, double ypos)
 {
-    vertical += 0.05f * delta * (HEIGHT / 2.0 - ypos);
-    horizontal += 0.05f * delta * (WIDTH / 2.0 - xpos);
-    direction = glm::vec3(cos(vertical) * sin(horizontal), sin(vertical), cos(vertical) * cos(horizontal));
-    right = glm::vec3(sin(horizontal - M_PI / 2.0f), 0, cos(horizontal - M_PI / 2.0f));
+    input.SetCursor(xpos, ypos);
 }
 
-void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+//one step of the simulation thread: held keys move the camera by speed * dt
+void Simulate(SimState &state, bool &paused, double &cursorX, double &cursorY, double dt)
 {
-    if (key == GLFW_KEY_W && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        cameraPos += direction * delta * speed;
+    uint32_t commands = input.Take();
+    bool changed = commands != 0 || !paused;
+    if (commands & COMMAND_RESET) {
+        state.horizontal = -1.25 * M_PI;
+        state.vertical = -M_PI / 5;
+        state.cameraPos = glm::vec3(-4.2, 4.0, 4.5);
+    }
+    if (commands & COMMAND_PAUSE) {
+        paused = !paused;
     }
-    if (key == GLFW_KEY_S && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        cameraPos -= direction * delta * speed;
+    double x, y;
+    input.Cursor(x, y);
+    if (x != cursorX || y != cursorY) {
+        state.vertical -= 0.05f * delta * (y - cursorY);
+        state.horizontal -= 0.05f * delta * (x - cursorX);
+        cursorX = x;
+        cursorY = y;
+        changed = true;
     }
-    if (key == GLFW_KEY_A && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        cameraPos -= right * delta * speed;
+    glm::vec3 direction = glm::vec3(cos(state.vertical) * sin(state.horizontal), sin(state.vertical), cos(state.vertical) * cos(state.horizontal));
+    glm::vec3 right = glm::vec3(sin(state.horizontal - M_PI / 2.0f), 0, cos(state.horizontal - M_PI / 2.0f));
+    const int keys[6] = {GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_R, GLFW_KEY_F};
+    const glm::vec3 moves[6] = {direction, -direction, -right, right, up, -up};
+    for (int i = 0; i < 6; ++i) {
+        if (input.Held(keys[i])) {
+            state.cameraPos += moves[i] * speed * (float)dt;
+            changed = true;
+        }
     }
-    if (key == GLFW_KEY_D && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        cameraPos += right * delta * speed;
+    if (!paused) {
+        state.time += dt;
     }
-    if (key == GLFW_KEY_R && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        cameraPos += up * delta * speed;
+    simStates.Back() = state;
+    simStates.Publish();
+    //wakes the render loop when it waits for events
+    if (changed) {
+        glfwPostEmptyEvent();
     }
-    if (key == GLFW_KEY_F && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        cameraPos -= up * delta * speed;
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (action != GLFW_REPEAT) {
+        input.SetKey(key, action == GLFW_PRESS);
     }
     if (key == GLFW_KEY_C && (action == GLFW_PRESS || action == GLFW_REPEAT)){
         glfwSetWindowShouldClose(window, true);
     }
     if (key == GLFW_KEY_1 && (action == GLFW_PRESS || action == GLFW_REPEAT)){
         show_map = false;
-        horizontal = -1.25 * M_PI;
-        vertical = -M_PI / 5;
-        cameraPos = glm::vec3(-4.2, 4.0, 4.5);
+        input.Post(COMMAND_RESET);
     }
     if (key == GLFW_KEY_2 && (action == GLFW_PRESS || action == GLFW_REPEAT)){
         show_map = true;
     }
+    if (key == GLFW_KEY_3 && action == GLFW_PRESS) {
+        occlusion_culling = !occlusion_culling;
+    }
+    if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) {
+        input.Post(COMMAND_PAUSE);
+    }
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+        profiler.SetEnabled(!profiler.Enabled());
+        std::cout << "Profiling " << (profiler.Enabled() ? "on" : "off") << std::endl;
+    }
+    if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+        //first press starts a trace, the second one writes it
+        if (Trace::Enabled()) {
+            Trace::Stop();
+            Trace::Dump(tracePath);
+        } else {
+            std::cout << "Tracing to " << tracePath << ", press P again to write it" << std::endl;
+            Trace::Start();
+            if (!profiler.Enabled()) {
+                profiler.SetEnabled(true);
+            }
+        }
+    }
 }
 
-int initGL()
+//the headless context loads glad itself, the window still needs it
+int initGL(bool loadFunctions)
 {
     int res = 0;
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    if (loadFunctions && !gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         std::cout << "Failed to initialize OpenGL context" << std::endl;
         return -1;
     }
@@ -92,47 +217,160 @@ int initGL()
     return 0;
 }
 
-unsigned int TextureLoading(const char* path)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    int width, height, tmp;
-    unsigned char *data = stbi_load(path, &width, &height, &tmp, 0);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    stbi_image_free(data);
-    return textureID;
-}
-
 int main(int argc, char** argv)
 {
-    if (!glfwInit()) {
-        return -1;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    int stressBoxes = 0;
+    int sphereSegments = 0;
+    bool headless = false;
+    bool syncReadback = false;
+    bool profile = false;
+    std::string benchPath;
+    std::string baselinePath;
+    double threshold = 10.0;
+    FrameRange frames;
+    std::string cameraFile;
+    std::string outputDir = "frames";
+    FarmSettings farm;
+    int rangeStart = 0;
+    int rangeCount = -1;
+    Tile tile;
+    //a coordinator passes every option except its own to the workers
+    std::vector<std::string> workerArgs(1, argv[0]);
+    for (int i = 1; i < argc; ++i) {
+        int optionStart = i;
+        bool farmOption = false;
+        if (!strcmp(argv[i], "--boxes") && i + 1 < argc) {
+            stressBoxes = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--sphere") && i + 1 < argc) {
+            sphereSegments = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--hiz")) {
+            occlusion_culling = true;
+        } else if (!strcmp(argv[i], "--idle-fps") && i + 1 < argc) {
+            redraw.idleFps = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--headless")) {
+            headless = true;
+        } else if (!strcmp(argv[i], "--sync-readback")) {
+            syncReadback = true;
+        } else if (!strcmp(argv[i], "--profile")) {
+            profile = true;
+        } else if (!strcmp(argv[i], "--bench") && i + 1 < argc) {
+            benchPath = argv[++i];
+            headless = true;
+        } else if (!strcmp(argv[i], "--baseline") && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (!strcmp(argv[i], "--threshold") && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            tracePath = argv[++i];
+            Trace::Start();
+        } else if (!strcmp(argv[i], "--size") && i + 1 < argc) {
+            sscanf(argv[++i], "%dx%d", &WIDTH, &HEIGHT);
+        } else if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames.count = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--time") && i + 1 < argc) {
+            sscanf(argv[++i], "%lf:%lf", &frames.start, &frames.end);
+        } else if (!strcmp(argv[i], "--fps") && i + 1 < argc) {
+            frames.fps = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--camera") && i + 1 < argc) {
+            cameraFile = argv[++i];
+        } else if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+            outputDir = argv[++i];
+            farmOption = true;
+        } else if (!strcmp(argv[i], "--workers") && i + 1 < argc) {
+            farm.workers = atoi(argv[++i]);
+            farmOption = true;
+        } else if (!strcmp(argv[i], "--tiles") && i + 1 < argc) {
+            sscanf(argv[++i], "%dx%d", &farm.tilesX, &farm.tilesY);
+            farmOption = true;
+        } else if (!strcmp(argv[i], "--chunk") && i + 1 < argc) {
+            farm.chunk = atoi(argv[++i]);
+            farmOption = true;
+        } else if (!strcmp(argv[i], "--timeout") && i + 1 < argc) {
+            farm.timeout = atof(argv[++i]);
+            farmOption = true;
+        } else if (!strcmp(argv[i], "--retries") && i + 1 < argc) {
+            farm.retries = atoi(argv[++i]);
+            farmOption = true;
+        } else if (!strcmp(argv[i], "--frame-range") && i + 1 < argc) {
+            sscanf(argv[++i], "%d:%d", &rangeStart, &rangeCount);
+        } else if (!strcmp(argv[i], "--tile") && i + 1 < argc) {
+            if (!ParseTile(argv[++i], tile)) {
+                std::cout << "Expected --tile x,y,width,height" << std::endl;
+                return -1;
+            }
+        }
+        if (!farmOption) {
+            workerArgs.insert(workerArgs.end(), argv + optionStart, argv + i + 1);
+        }
     }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
-    GLFWwindow*  window = glfwCreateWindow(WIDTH, HEIGHT, "task3", nullptr, nullptr);
-    if (window == nullptr) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
+    Trace::SetThreadName("main");
+    CameraPath cameraPath;
+    if (!cameraFile.empty() && !cameraPath.Load(cameraFile)) {
         return -1;
     }
-    glfwSetKeyCallback(window, key_callback);
-    glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
-    glfwSetCursorPosCallback (window, mouseMove);
-    glfwSetWindowSizeCallback(window, windowResize);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glfwMakeContextCurrent(window);
-    if (initGL() != 0) {
+    if (frames.fps <= 0.0) {
+        frames.fps = 60.0;
+    }
+    int frameCount = frames.FrameCount();
+    if (farm.workers > 0) {
+        return RunCoordinator(workerArgs, farm, frameCount, WIDTH, HEIGHT, outputDir) ? 0 : -1;
+    }
+    //a worker renders only part of the sequence
+    if (rangeCount >= 0) {
+        rangeStart = std::min(std::max(rangeStart, 0), frameCount);
+        frameCount = std::min(rangeCount, frameCount - rangeStart);
+    }
+    //and maybe only a tile of the WIDTH x HEIGHT frame: its projection is the matching part of the full one
+    glm::mat4 tileMatrix = glm::mat4(1.0f);
+    double aspect = 0.0;
+    if (!tile.Empty()) {
+        aspect = (double)WIDTH / (double)HEIGHT;
+        glm::vec2 scale = glm::vec2((float)WIDTH / tile.width, (float)HEIGHT / tile.height);
+        glm::vec2 centre = glm::vec2((2.0f * tile.x + tile.width) / WIDTH - 1.0f, 1.0f - (2.0f * tile.y + tile.height) / HEIGHT);
+        tileMatrix = glm::scale(glm::vec3(scale, 1.0f)) * glm::translate(glm::vec3(-centre, 0.0f));
+        WIDTH = tile.width;
+        HEIGHT = tile.height;
+    }
+    if (!OpenAssets()) {
+        std::cout << "assets.pak not found next to the executable, reading the source tree" << std::endl;
+    }
+    GLFWwindow* window = nullptr;
+    HeadlessContext offscreen;
+    if (headless) {
+        if (!offscreen.Init(WIDTH, HEIGHT)) {
+            return -1;
+        }
+    } else {
+        if (!glfwInit()) {
+            return -1;
+        }
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
+        window = glfwCreateWindow(WIDTH, HEIGHT, "task3", nullptr, nullptr);
+        if (window == nullptr) {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwSetKeyCallback(window, key_callback);
+        glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
+        glfwSetCursorPosCallback (window, mouseMove);
+        glfwSetWindowSizeCallback(window, windowResize);
+        glfwSetWindowRefreshCallback(window, windowRefresh);
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        double cursorX, cursorY;
+        glfwGetCursorPos(window, &cursorX, &cursorY);
+        input.SetCursor(cursorX, cursorY);
+        glfwMakeContextCurrent(window);
+    }
+    if (initGL(!headless) != 0) {
         return -1;
     }
+    //frames go to the window or to the offscreen framebuffer
+    GLuint outputFBO = offscreen.Framebuffer();
     GLenum gl_error = glGetError();
     while (gl_error != GL_NO_ERROR) {
         gl_error = glGetError();
@@ -143,19 +381,23 @@ int main(int argc, char** argv)
 
     std::unordered_map<GLenum, std::string> shaders;
 
-    shaders[GL_VERTEX_SHADER] = "vertex_SM.glsl";
-    shaders[GL_FRAGMENT_SHADER] = "fragment_SM.glsl";
+    shaders[GL_VERTEX_SHADER] = "shaders/vertex_SM.glsl";
+    shaders[GL_FRAGMENT_SHADER] = "shaders/fragment_SM.glsl";
     ShaderProgram program_SM(shaders);
 
-    shaders[GL_VERTEX_SHADER] = "vertex_DEPTH.glsl";
-    shaders[GL_FRAGMENT_SHADER] = "fragment_DEPTH.glsl";
+    shaders[GL_VERTEX_SHADER] = "shaders/vertex_DEPTH.glsl";
+    shaders[GL_FRAGMENT_SHADER] = "shaders/fragment_DEPTH.glsl";
     ShaderProgram program_DEPTH(shaders);
 
-    shaders[GL_VERTEX_SHADER] = "vertex_SHOW_DEPTH.glsl";
-    shaders[GL_FRAGMENT_SHADER] = "fragment_SHOW_DEPTH.glsl";
+    shaders[GL_VERTEX_SHADER] = "shaders/vertex_SHOW_DEPTH.glsl";
+    shaders[GL_FRAGMENT_SHADER] = "shaders/fragment_SHOW_DEPTH.glsl";
     ShaderProgram program_SHOW_DEPTH(shaders);
 
-    glfwSwapInterval(1);
+    if (window) {
+        glfwSwapInterval(1);
+    }
+
+    TextureLoader textureLoader(ExecutableDir() + "/texture_cache");
 
     float cube_vertices[] = {
 
@@ -214,7 +456,7 @@ int main(int argc, char** argv)
         glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
         glEnableVertexAttribArray(2);
     glBindVertexArray(0);
-    unsigned int boxTexture = TextureLoading("../textures/box.jpg");
+    unsigned int boxTexture = textureLoader.Load("textures/box.jpg");
     glm::vec3 cubePositions[] = {
         glm::vec3(-1.3, 1.0, 0.0),
         glm::vec3(1.5, 1.0, 0.0)
@@ -245,7 +487,7 @@ int main(int argc, char** argv)
         glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
         glEnableVertexAttribArray(2);
     glBindVertexArray(0);
-    unsigned int grassTexture = TextureLoading("../textures/grass.jpg");
+    unsigned int grassTexture = textureLoader.Load("textures/grass.jpg");
     glm::mat4 modelPlane;
     modelPlane = glm::scale(glm::vec3(2.0));
 
@@ -279,7 +521,7 @@ int main(int argc, char** argv)
         glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
         glEnableVertexAttribArray(2);
     glBindVertexArray(0);
-    unsigned int tetrTexture = TextureLoading("../textures/ball2.jpg");
+    unsigned int tetrTexture = textureLoader.Load("textures/ball2.jpg");
     glm::vec3 tetrPosition = glm::vec3(-1.5, 0.7, 0.0);
 
     float quad_vertices[] = {
@@ -303,6 +545,53 @@ int main(int argc, char** argv)
         glEnableVertexAttribArray(1);
     glBindVertexArray(0);
 
+    AABB cubeBox = {glm::vec3(-1.0), glm::vec3(1.0)};
+    AABB planeBox = {glm::vec3(-2.0, 0.0, -2.0), glm::vec3(2.0, 0.0, 2.0)};
+    AABB tetrBox = {glm::vec3(-0.5, 0.0, -cube_root / 2.0), glm::vec3(1.0, sqrt_2, cube_root / 2.0)};
+    std::vector<SceneObject> objects;
+    objects.push_back({cubeVAO, 36, boxTexture, modelBox1, NormalMatrix(modelBox1), cubeBox});
+    objects.push_back({cubeVAO, 36, boxTexture, modelBox2, NormalMatrix(modelBox2), cubeBox});
+    objects.push_back({planeVAO, 6, grassTexture, modelPlane, NormalMatrix(modelPlane), planeBox});
+    const size_t tetrIndex = objects.size();
+    objects.push_back({tetrVAO, 12, tetrTexture, glm::mat4(1.0), glm::mat3(1.0), tetrBox});
+    unsigned int sphereVBO = 0, sphereVAO = 0;
+    if (sphereSegments > 0) {
+        std::vector<float> sphere_vertices = SphereVertices(sphereSegments);
+        glGenVertexArrays(1, &sphereVAO);
+        glGenBuffers(1, &sphereVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
+        glBufferData(GL_ARRAY_BUFFER, sphere_vertices.size() * sizeof(float), sphere_vertices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(sphereVAO);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+            glEnableVertexAttribArray(2);
+        glBindVertexArray(0);
+        glm::mat4 modelSphere = glm::scale(glm::translate(glm::vec3(0.0, 0.7, 2.5)), glm::vec3(0.7));
+        objects.push_back({sphereVAO, (int)sphere_vertices.size() / 8, tetrTexture, modelSphere, NormalMatrix(modelSphere), cubeBox});
+    }
+    if (stressBoxes > 0) {
+        int side = (int)std::ceil(std::sqrt((float)stressBoxes));
+        float spacing = 40.0f / side;
+        float size = 0.25f * spacing;
+        for (int i = 0; i < stressBoxes; ++i) {
+            glm::vec3 position = glm::vec3(-20.0 + spacing * (i % side + 0.5), size, -20.0 + spacing * (i / side + 0.5));
+            glm::mat4 model = glm::scale(glm::translate(position), glm::vec3(size));
+            objects.push_back({cubeVAO, 36, boxTexture, model, NormalMatrix(model), cubeBox});
+        }
+    }
+    CullingSet cullingSet;
+    cullingSet.Resize(objects.size());
+    for (size_t i = 0; i < objects.size(); ++i) {
+        cullingSet.Set(i, TransformAABB(objects[i].localBox, objects[i].model));
+    }
+    std::vector<unsigned char> shadowVisible, cameraVisible;
+    size_t shadowCount = 0, cameraCount = 0, occludedCount = 0;
+    bool titleDirty = true;
+    HiZBuffer hiz;
+
     const int WIDTH_DEPTH = 1024, HEIGHT_DEPTH = 1024;
     unsigned int depthFBO;
     glGenFramebuffers(1, &depthFBO);
@@ -331,58 +620,219 @@ int main(int argc, char** argv)
 
     glm::vec3 lightPos = glm::vec3(-3.0, 4.0, -1.5);
 
-    while (!glfwWindowShouldClose(window)) {
+    bool firstFrame = true;
+    bool texturesReady = false;
+    if (headless) {
+        //every written frame has the final textures
+        while (!textureLoader.Done()) {
+            textureLoader.Update();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    std::unique_ptr<FrameWriter> writer;
+    //frames are read back through a PBO ring unless --sync-readback asks for plain glReadPixels
+    ReadbackRing readback;
+    if (headless && benchPath.empty()) {
+        writer.reset(new FrameWriter());
+        if (!syncReadback && !readback.Init(WIDTH, HEIGHT)) {
+            std::cout << "Failed to create pixel buffers, reading frames synchronously" << std::endl;
+            readback.Release();
+            syncReadback = true;
+        }
+    }
+    std::vector<unsigned char> pixels;
+    int readyFrame = 0;
+    double captureTime = 0.0;
+    const int PASS_FRAME = profiler.AddPass("frame", false);
+    const int PASS_CULLING = profiler.AddPass("culling", false);
+    const int PASS_SHADOW = profiler.AddPass("shadow depth");
+    const int PASS_HIZ = profiler.AddPass("hi-z");
+    const int PASS_LIT = profiler.AddPass("lit");
+    const int PASS_DEPTH_VIEW = profiler.AddPass("depth view");
+    const int PASS_PRESENT = profiler.AddPass(!headless ? "swap" : benchPath.empty() ? "capture" : "finish", false);
+    //a trace started from the command line gets the passes too, without the console summary
+    if (Trace::Enabled() && !profile) {
+        profiler.reportInterval = 0;
+    }
+    //a benchmark keeps every frame after the warm-up and writes no images
+    const int BENCH_WARMUP = 10;
+    bool bench = !benchPath.empty();
+    if (bench) {
+        profiler.reportInterval = 0;
+        profiler.window = std::max(frameCount - BENCH_WARMUP, 1);
+    }
+    profiler.SetEnabled(profile || Trace::Enabled() || bench);
+    std::chrono::steady_clock::time_point loopStart = std::chrono::steady_clock::now();
+    int frame = rangeStart;
+    double sceneTime = 0.0;
+    SimState simState = {cameraPos, horizontal, vertical, 0.0};
+    bool simPaused = false;
+    double simCursorX, simCursorY;
+    input.Cursor(simCursorX, simCursorY);
+    if (window) {
+        simulation.Start(SIMULATION_RATE, [&](double dt) { Simulate(simState, simPaused, simCursorX, simCursorY, dt); });
+    }
+    while (headless ? frame < rangeStart + frameCount : !glfwWindowShouldClose(window)) {
+        if (bench && frame == rangeStart + BENCH_WARMUP) {
+            profiler.SetEnabled(true);
+        }
+        if (window) {
+            if (simStates.Update()) {
+                cameraPos = simStates.Front().cameraPos;
+                horizontal = simStates.Front().horizontal;
+                vertical = simStates.Front().vertical;
+                sceneTime = simStates.Front().time;
+                direction = glm::vec3(cos(vertical) * sin(horizontal), sin(vertical), cos(vertical) * cos(horizontal));
+                right = glm::vec3(sin(horizontal - M_PI / 2.0f), 0, cos(horizontal - M_PI / 2.0f));
+            }
+            //an unchanged scene is not drawn again, the loop sleeps until an event
+            const float view[] = {cameraPos.x, cameraPos.y, cameraPos.z, horizontal, vertical, (float)sceneTime,
+                                  (float)WIDTH, (float)HEIGHT, (float)show_map, (float)occlusion_culling};
+            //culling uses a pyramid a few frames old, it has to catch up with the last view
+            if (redraw.Changed(view, sizeof(view) / sizeof(view[0])) && occlusion_culling) {
+                redraw.Request(HiZBuffer::READBACKS + 1);
+            }
+            if (!texturesReady) {
+                redraw.Request();
+            }
+            if (!redraw.NextFrame()) {
+                TRACE_SCOPE("wait for events");
+                redraw.Wait();
+                continue;
+            }
+        }
+        profiler.Begin(PASS_FRAME);
 
-        glfwSetCursorPos(window, WIDTH / 2, HEIGHT / 2);
-        glfwPollEvents();
+        if (window) {
+            TRACE_SCOPE("poll input");
+            glfwPollEvents();
+        }
+        if (!texturesReady) {
+            textureLoader.Update();
+            if (textureLoader.Done()) {
+                texturesReady = true;
+                std::cout << "Textures ready: " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count() << " ms" << std::endl;
+            }
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        //headless frames get their time from the frame number only, so any frame can be rendered again
+        double cur_time = headless ? frames.FrameTime(frame) : sceneTime;
+        if (!cameraPath.Empty()) {
+            CameraKey key = cameraPath.Sample(cur_time);
+            cameraPos = glm::vec3(key.position[0], key.position[1], key.position[2]);
+            horizontal = key.yaw;
+            vertical = key.pitch;
+            direction = glm::vec3(cos(vertical) * sin(horizontal), sin(vertical), cos(vertical) * cos(horizontal));
+            right = glm::vec3(sin(horizontal - M_PI / 2.0f), 0, cos(horizontal - M_PI / 2.0f));
+        }
+        glm::vec3 newPosition;
+        while (cur_time > 4 * M_PI) {
+            cur_time -= 4 * M_PI;
+        }
+        if (cur_time < 2 * M_PI) {
+            newPosition = tetrPosition + (float)1.3 * glm::vec3(cos(cur_time), 0, -sin(cur_time));
+        } else {
+            newPosition = tetrPosition + (float)2.5 * glm::vec3(cos(M_PI + cur_time), 0, sin(M_PI + cur_time)) + glm::vec3(3.8, 0.0, 0.0);
+        }
+        glm::mat4 model = glm::mat4(1.0);
+        model = glm::translate(model, newPosition);
+        model = glm::rotate(model, (float)M_PI, glm::vec3(0.0, 0.0, 1.0));
+        model = glm::rotate(model, (float)cur_time, glm::vec3(0.0, 1.0, 0.0));
+        model = glm::scale(model, glm::vec3(0.5));
+        objects[tetrIndex].model = model;
+        objects[tetrIndex].normalMatrix = NormalMatrix(model);
+        cullingSet.Set(tetrIndex, TransformAABB(objects[tetrIndex].localBox, model));
+
         glm::mat4 light_P, light_V;
         glm::mat4 lightVP;
         light_P = glm::ortho(-10.0, 10.0, -10.0, 10.0, 0.1,  8.0);
         light_V = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
         lightVP = light_P * light_V;
+        glm::mat4 projection = tileMatrix * glm::mat4(glm::perspective(glm::radians(60.0), aspect > 0.0 ? aspect : (double)WIDTH / (double)HEIGHT, 0.1, 100.0));
+        glm::mat4 view = glm::lookAt(cameraPos, cameraPos + direction, up);
+
+        glm::mat4 cameraVP = projection * view;
+        profiler.Begin(PASS_CULLING);
+        size_t newShadowCount = cullingSet.Cull(ExtractFrustum(lightVP), shadowVisible);
+        size_t newCameraCount = cullingSet.Cull(ExtractFrustum(cameraVP), cameraVisible);
+        if (newShadowCount != shadowCount || newCameraCount != cameraCount) {
+            shadowCount = newShadowCount;
+            cameraCount = newCameraCount;
+            titleDirty = true;
+        }
+        profiler.End(PASS_CULLING);
+
+        profiler.Begin(PASS_SHADOW);
         program_DEPTH.StartUseShader();
             program_DEPTH.SetUniform("lightVP", lightVP);
             glViewport(0, 0, WIDTH_DEPTH, HEIGHT_DEPTH);
             glBindFramebuffer(GL_FRAMEBUFFER, depthFBO);
                 glClear(GL_DEPTH_BUFFER_BIT);
-                double cur_time = glfwGetTime();
-                glBindVertexArray(cubeVAO);
-                    program_DEPTH.SetUniform("model", modelBox1);
-                    glDrawArrays(GL_TRIANGLES, 0, 36);
-                    program_DEPTH.SetUniform("model", modelBox2);
-                    glDrawArrays(GL_TRIANGLES, 0, 36);
-                glBindVertexArray(planeVAO);
-                    program_DEPTH.SetUniform("model", modelPlane);
-                    glDrawArrays(GL_TRIANGLES, 0, 6);
-                glBindVertexArray(0);
-                glBindVertexArray(tetrVAO);
-                    glm::vec3 newPosition;
-                    while (cur_time > 4 * M_PI) {
-                        cur_time -= 4 * M_PI;
-                    }
-                    if (cur_time < 2 * M_PI) {
-                        newPosition = tetrPosition + (float)1.3 * glm::vec3(cos(cur_time), 0, -sin(cur_time));
-                    } else {
-                        newPosition = tetrPosition + (float)2.5 * glm::vec3(cos(M_PI + cur_time), 0, sin(M_PI + cur_time)) + glm::vec3(3.8, 0.0, 0.0);
+                for (size_t i = 0; i < objects.size(); ++i) {
+                    if (!shadowVisible[i]) {
+                        continue;
                     }
-                    glm::mat4 model = glm::mat4(1.0);
-                    model = glm::translate(model, newPosition);
-                    model = glm::rotate(model, (float)M_PI, glm::vec3(0.0, 0.0, 1.0));
-                    model = glm::rotate(model, (float)cur_time, glm::vec3(0.0, 1.0, 0.0));
-                    model = glm::scale(model, glm::vec3(0.5));
-                    program_DEPTH.SetUniform("model", model);
-                    glDrawArrays(GL_TRIANGLES, 0, 12);
+                    glBindVertexArray(objects[i].VAO);
+                    program_DEPTH.SetUniform("model", objects[i].model);
+                    glDrawArrays(GL_TRIANGLES, 0, objects[i].vertexCount);
+                }
                 glBindVertexArray(0);
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
         program_DEPTH.StopUseShader();
+        profiler.End(PASS_SHADOW);
+
+        size_t newOccludedCount = 0;
+        if (occlusion_culling && !show_map) {
+            if (hiz.Width() != WIDTH || hiz.Height() != HEIGHT) {
+                hiz.Init(WIDTH, HEIGHT);
+            }
+            profiler.Begin(PASS_HIZ);
+            program_DEPTH.StartUseShader();
+                program_DEPTH.SetUniform("lightVP", cameraVP);
+                hiz.Begin();
+                    //the tetrahedron moves, its old depth would hide what is behind it now
+                    for (size_t i = 0; i < objects.size(); ++i) {
+                        if (!cameraVisible[i] || i == tetrIndex) {
+                            continue;
+                        }
+                        glBindVertexArray(objects[i].VAO);
+                        program_DEPTH.SetUniform("model", objects[i].model);
+                        glDrawArrays(GL_TRIANGLES, 0, objects[i].vertexCount);
+                    }
+                    glBindVertexArray(0);
+                hiz.End(cameraVP);
+            program_DEPTH.StopUseShader();
+            profiler.End(PASS_HIZ);
+            for (size_t i = 0; i < objects.size(); ++i) {
+                if (cameraVisible[i] && hiz.IsOccluded(cullingSet.Get(i), cameraVP)) {
+                    cameraVisible[i] = 0;
+                    ++newOccludedCount;
+                }
+            }
+        } else {
+            hiz.Invalidate();
+        }
+        if (newOccludedCount != occludedCount) {
+            occludedCount = newOccludedCount;
+            titleDirty = true;
+        }
+        if (titleDirty && window) {
+            std::string title = "task3 | shadow pass " + std::to_string(shadowCount) + "/" + std::to_string(objects.size()) +
+                                " | camera pass " + std::to_string(cameraCount) + "/" + std::to_string(objects.size()) +
+                                " | occluded " + std::to_string(occludedCount);
+            glfwSetWindowTitle(window, title.c_str());
+            titleDirty = false;
+        }
 
+        glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
         glViewport(0, 0, WIDTH, HEIGHT);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         if (show_map) {
+             profiler.Begin(PASS_DEPTH_VIEW);
              program_SHOW_DEPTH.StartUseShader();
                  glActiveTexture(GL_TEXTURE0);
                  glBindTexture(GL_TEXTURE_2D, depthMap);
@@ -390,62 +840,97 @@ int main(int argc, char** argv)
                      glDrawArrays(GL_TRIANGLES, 0, 6);
                  glBindVertexArray(0);
              program_SHOW_DEPTH.StopUseShader();
+             profiler.End(PASS_DEPTH_VIEW);
         } else {
+            profiler.Begin(PASS_LIT);
             program_SM.StartUseShader();
-                glm::mat4 projection = glm::perspective(glm::radians(60.0), (double)WIDTH / (double)HEIGHT, 0.1, 100.0);
-                glm::mat4 view = glm::lookAt(cameraPos, cameraPos + direction, up);
-                program_SM.SetUniform("projection", projection);
-                program_SM.SetUniform("view", view);
+                program_SM.SetUniform("viewProjection", cameraVP);
                 program_SM.SetUniform("viewPos", cameraPos);
                 program_SM.SetUniform("lightPos", lightPos);
                 program_SM.SetUniform("lightVP", lightVP);
                 glActiveTexture(GL_TEXTURE1);
                 glBindTexture(GL_TEXTURE_2D, depthMap);
-                double cur_time = glfwGetTime();
-                glm::mat4 model = glm::mat4(1.0);
-                GL_CHECK_ERRORS;
-                glBindVertexArray(cubeVAO);
-                    glActiveTexture(GL_TEXTURE2);
-                    glBindTexture(GL_TEXTURE_2D, boxTexture);
-                    program_SM.SetUniform("model", modelBox1);
-                    glDrawArrays(GL_TRIANGLES, 0, 36);
-                    program_SM.SetUniform("model", modelBox2);
-                    glDrawArrays(GL_TRIANGLES, 0, 36);
-                glBindVertexArray(0);
-                GL_CHECK_ERRORS;
-                glBindVertexArray(planeVAO);
-                    glActiveTexture(GL_TEXTURE2);
-                    glBindTexture(GL_TEXTURE_2D, grassTexture);
-                    program_SM.SetUniform("model", modelPlane);
-                    glDrawArrays(GL_TRIANGLES, 0, 6);
-                glBindVertexArray(0);
                 GL_CHECK_ERRORS;
-                glBindVertexArray(tetrVAO);
-                    glActiveTexture(GL_TEXTURE2);
-                    glBindTexture(GL_TEXTURE_2D, tetrTexture);
-                    glm::vec3 newPosition;
-                    while (cur_time > 4 * M_PI) {
-                        cur_time -= 4 * M_PI;
+                glActiveTexture(GL_TEXTURE2);
+                for (size_t i = 0; i < objects.size(); ++i) {
+                    if (!cameraVisible[i]) {
+                        continue;
                     }
-                    if (cur_time < 2 * M_PI) {
-                        newPosition = tetrPosition + (float)1.3 * glm::vec3(cos(cur_time), 0, -sin(cur_time));
-                    } else {
-                        newPosition = tetrPosition + (float)2.5 * glm::vec3(cos(M_PI + cur_time), 0, sin(M_PI + cur_time)) + glm::vec3(3.8, 0.0, 0.0);
-                    }
-                    model = glm::mat4(1.0);
-                    model = glm::translate(model, newPosition);
-                    model = glm::rotate(model, (float)M_PI, glm::vec3(0.0, 0.0, 1.0));
-                    model = glm::rotate(model, (float)cur_time, glm::vec3(0.0, 1.0, 0.0));
-                    model = glm::scale(model, glm::vec3(0.5));
-                    program_SM.SetUniform("model", model);
-                    glDrawArrays(GL_TRIANGLES, 0, 12);
+                    glBindVertexArray(objects[i].VAO);
+                    glBindTexture(GL_TEXTURE_2D, objects[i].texture);
+                    program_SM.SetUniform("model", objects[i].model);
+                    program_SM.SetUniform("normalMatrix", objects[i].normalMatrix);
+                    glDrawArrays(GL_TRIANGLES, 0, objects[i].vertexCount);
+                }
                 glBindVertexArray(0);
             program_SM.StopUseShader();
+            profiler.End(PASS_LIT);
             GL_CHECK_ERRORS;
         }
-        glfwSwapBuffers(window);
+        profiler.Begin(PASS_PRESENT);
+        if (window) {
+            glfwSwapBuffers(window);
+        } else if (bench) {
+            glFinish();
+        } else {
+            std::chrono::steady_clock::time_point captureStart = std::chrono::steady_clock::now();
+            if (syncReadback) {
+                offscreen.ReadPixels(pixels);
+                writer->Push(FramePath(outputDir, frame), WIDTH, HEIGHT, std::move(pixels));
+            } else {
+                readback.Start(outputFBO, frame);
+                while (readback.Take(pixels, readyFrame, readback.Full())) {
+                    writer->Push(FramePath(outputDir, readyFrame), WIDTH, HEIGHT, std::move(pixels));
+                }
+            }
+            captureTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - captureStart).count();
+        }
+        profiler.End(PASS_PRESENT);
+        profiler.End(PASS_FRAME);
+        profiler.EndFrame();
+        ++frame;
+        if (firstFrame) {
+            firstFrame = false;
+            std::cout << "Time to first frame: " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count() << " ms" << std::endl;
+        }
+    }
+    simulation.Stop();
+    if (headless && frameCount > 0 && !bench) {
+        std::chrono::steady_clock::time_point captureStart = std::chrono::steady_clock::now();
+        while (readback.Take(pixels, readyFrame, true)) {
+            writer->Push(FramePath(outputDir, readyFrame), WIDTH, HEIGHT, std::move(pixels));
+        }
+        captureTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - captureStart).count();
+        double loopTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loopStart).count();
+        std::cout << "Capture (" << (syncReadback ? "synchronous glReadPixels" : "PBO ring") << "): " << captureTime / frameCount
+                  << " ms/frame of " << loopTime / frameCount << " ms/frame" << std::endl;
     }
+    readback.Release();
+    if (headless && profile) {
+        profiler.PrintSummary();
+    }
+    int exitCode = 0;
+    if (bench) {
+        if (frameCount <= BENCH_WARMUP) {
+            std::cout << "A benchmark needs more than " << BENCH_WARMUP << " frames" << std::endl;
+            exitCode = -1;
+        } else {
+            profiler.PrintSummary();
+            if (!WriteBenchReport(benchPath, profiler, WIDTH, HEIGHT, frameCount - BENCH_WARMUP)) {
+                exitCode = -1;
+            } else if (!baselinePath.empty() && !CompareBenchReport(baselinePath, profiler, threshold)) {
+                exitCode = -1;
+            }
+        }
+    }
+    if (Trace::Enabled()) {
+        Trace::Stop();
+        Trace::Dump(tracePath);
+    }
+    profiler.Release();
     GL_CHECK_ERRORS;
+    hiz.Release();
+    textureLoader.Release();
     glDeleteVertexArrays(1, &cubeVAO);
     glDeleteBuffers(1, &cubeVBO);
     glDeleteVertexArrays(1, &planeVAO);
@@ -454,6 +939,20 @@ int main(int argc, char** argv)
     glDeleteBuffers(1, &tetrVBO);
     glDeleteVertexArrays(1, &quadVAO);
     glDeleteBuffers(1, &quadVBO);
-    glfwTerminate();
-    return 0;
+    if (sphereVAO) {
+        glDeleteVertexArrays(1, &sphereVAO);
+        glDeleteBuffers(1, &sphereVBO);
+    }
+    if (window) {
+        glfwTerminate();
+    }
+    offscreen.Release();
+    if (writer) {
+        writer->Finish();
+        if (writer->Failed()) {
+            std::cout << writer->Failed() << " frames were not written" << std::endl;
+            return -1;
+        }
+    }
+    return exitCode;
 }
@@ -9,16 +9,16 @@ out vec3 fragNormal;
 out vec2 texCoords;
 out vec4 fragPosLight;
 
-uniform mat4 projection;
-uniform mat4 view;
+uniform mat4 viewProjection;
 uniform mat4 model;
+uniform mat3 normalMatrix;
 uniform mat4 lightVP;
 
 void main()
 {
     fragPos = vec3(model * vec4(fragPosIn, 1.0));
-    fragNormal = transpose(inverse(mat3(model))) * texNormalIn;
+    fragNormal = normalMatrix * texNormalIn;
     texCoords = texCoordsIn;
     fragPosLight = lightVP * vec4(fragPos, 1.0);
-    gl_Position = projection * view * vec4(fragPos, 1.0);
+    gl_Position = viewProjection * vec4(fragPos, 1.0);
 }
@@ -0,0 +1,59 @@
+//offline texture cooker: fills the texture cache so the programs only have to upload
+//usage: texcook [--rgba] <cache dir> <image> [<image> ...]
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "TextureCache.h"
+
+#define STB_IMAGE_IMPLEMENTATION 1
+#define STBI_ONLY_JPEG 1
+#define STBI_ONLY_TGA 1
+#include "stb_image.h"
+
+int main(int argc, char** argv)
+{
+    bool compress = true;
+    int first = 1;
+    if (argc > 1 && !strcmp(argv[1], "--rgba")) {
+        compress = false;
+        first = 2;
+    }
+    if (argc - first < 2) {
+        std::cout << "usage: texcook [--rgba] <cache dir> <image> [<image> ...]" << std::endl;
+        return 1;
+    }
+    std::string cacheDir = argv[first];
+    int failed = 0;
+    for (int i = first + 1; i < argc; ++i) {
+        std::string path = argv[i];
+        MappedFile source;
+        if (!source.Open(path)) {
+            std::cout << "Can't open " << path << std::endl;
+            ++failed;
+            continue;
+        }
+        //the programs upload TGA rows in file order (bottom-up) and JPEG rows top-down
+        bool tga = path.size() > 4 && path.compare(path.size() - 4, 4, ".tga") == 0;
+        stbi_set_flip_vertically_on_load(tga);
+        int width, height, channels;
+        unsigned char *pixels = stbi_load_from_memory(source.Data(), (int)source.Size(), &width, &height, &channels, 4);
+        if (!pixels) {
+            std::cout << "Can't decode " << path << ": " << stbi_failure_reason() << std::endl;
+            ++failed;
+            continue;
+        }
+        CookedTexture texture;
+        CookTexture(pixels, width, height, compress, texture);
+        stbi_image_free(pixels);
+        std::string cachePath = CachePath(cacheDir, HashBytes(source.Data(), source.Size()), compress);
+        if (!WriteKtx(cachePath, texture)) {
+            std::cout << "Can't write " << cachePath << std::endl;
+            ++failed;
+            continue;
+        }
+        std::cout << path << " -> " << cachePath << " (" << texture.levels.size() << " levels)" << std::endl;
+    }
+    return failed ? 1 : 0;
+}